@@ -3,25 +3,1371 @@
 #include <osvr/PluginKit/TrackerInterfaceC.h>
 #include <osvr/PluginKit/AnalogInterfaceC.h>
 #include <osvr/PluginKit/ButtonInterfaceC.h>
+#include <osvr/Util/TimeValueC.h>
 
 #include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include <string>
 
 #include <PSMoveClient_CAPI.h>
 #include <ClientGeometry_CAPI.h>
 
 #include <json/json.h>
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define POSE_BATCH_SSE 1
+#else
+#define POSE_BATCH_SSE 0
+#endif
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace 
 {
+	// Single producer, single consumer triple buffer. The producer fills back() and publishes it,
+	// the consumer always sees the most recently published value. Neither side ever blocks.
+	template <typename T>
+	class TripleBuffer {
+	public:
+		T& back() {
+			return buffers_[back_];
+		}
+		void publish() {
+			back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX;
+		}
+		const T& front() {
+			if (middle_.load(std::memory_order_relaxed) & FRESH)
+				front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+			return buffers_[front_];
+		}
+		void fill(const T& value) {
+			for (T& buffer : buffers_)
+				buffer = value;
+		}
+	private:
+		static const int INDEX = 3;
+		static const int FRESH = 4;
+		T buffers_[3] = {};
+		std::atomic<int> middle_{ 1 };
+		int back_ = 0;
+		int front_ = 2;
+	};
+
+	typedef std::chrono::steady_clock clock;
+
+	double time_value_seconds(const OSVR_TimeValue& time) {
+		return time.seconds + time.microseconds / 1e6;
+	}
+
+	OSVR_TimeValue seconds_time_value(double seconds) {
+		OSVR_TimeValue time;
+		time.seconds = (OSVR_TimeValue_Seconds)std::floor(seconds);
+		time.microseconds = (OSVR_TimeValue_Microseconds)std::llround((seconds - std::floor(seconds)) * 1e6);
+		osvrTimeValueNormalize(&time);
+		return time;
+	}
+
+	// Maps sample times on PSMoveService's clock onto the local OSVR clock. The offset between the
+	// two is the smallest (receive time - sample time) seen, i.e. the sample that got here fastest,
+	// and is allowed to creep back up slowly so it follows drift and forgets outliers.
+	class ClockMapper {
+	public:
+		OSVR_TimeValue map(double sample_seconds, const OSVR_TimeValue& received) {
+			if (sample_seconds <= 0)
+				return received;
+			const double received_seconds = time_value_seconds(received);
+			const double offset = received_seconds - sample_seconds;
+			if (!valid_ || offset < offset_ || std::abs(offset - offset_) > RESYNC_SECONDS)
+				offset_ = offset;
+			else
+				offset_ += (offset - offset_) * DRIFT_GAIN;
+			valid_ = true;
+			return seconds_time_value(std::min(sample_seconds + offset_, received_seconds));
+		}
+	private:
+		static constexpr double DRIFT_GAIN = 0.001;
+		static constexpr double RESYNC_SECONDS = 1.0;	// Treat a jump this big as PSMoveService restarting its clock
+		bool valid_ = false;
+		double offset_ = 0;
+	};
+
+	// Metrics are only gathered when something will read them, the debug log or a metrics file
+	bool metrics_enabled = false;
+
+	// Event counter with a single writing thread, readable from any other
+	class Counter {
+	public:
+		void add(uint64_t n = 1) {
+			value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+		}
+		uint64_t value() const {
+			return value_.load(std::memory_order_relaxed);
+		}
+	private:
+		std::atomic<uint64_t> value_{ 0 };
+	};
+
+	// Histogram of durations in microseconds, laid out like an HdrHistogram: each power of two is split
+	// into 8 buckets, so percentiles are within 12.5%. It only ever counts up; the reader takes snapshots
+	// and subtracts the previous one to get an interval. Single writer, like Counter.
+	class Histogram {
+	public:
+		static const size_t SUB_BUCKETS = 8;
+		static const size_t BUCKETS = 40 * SUB_BUCKETS;
+
+		struct Snapshot {
+			std::array<uint64_t, BUCKETS> counts = {};
+			uint64_t sum_us = 0;
+
+			Snapshot operator-(const Snapshot& earlier) const {
+				Snapshot interval;
+				for (size_t i = 0; i < BUCKETS; i++)
+					interval.counts[i] = counts[i] - earlier.counts[i];
+				interval.sum_us = sum_us - earlier.sum_us;
+				return interval;
+			}
+			uint64_t count() const {
+				uint64_t total = 0;
+				for (uint64_t n : counts)
+					total += n;
+				return total;
+			}
+			// Upper bound of the bucket holding the p-th percentile, 0 if empty
+			uint64_t percentile(double p) const {
+				const uint64_t total = count();
+				if (total == 0)
+					return 0;
+				const uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(p / 100.0 * total));
+				uint64_t seen = 0;
+				for (size_t i = 0; i < BUCKETS; i++) {
+					seen += counts[i];
+					if (seen >= rank)
+						return upper_bound(i);
+				}
+				return upper_bound(BUCKETS - 1);
+			}
+			Json::Value to_json() const {
+				Json::Value summary;
+				const uint64_t total = count();
+				summary["count"] = (Json::UInt64)total;
+				summary["mean"] = total ? (double)sum_us / total : 0.0;
+				summary["p50"] = (Json::UInt64)percentile(50);
+				summary["p90"] = (Json::UInt64)percentile(90);
+				summary["p99"] = (Json::UInt64)percentile(99);
+				summary["max"] = (Json::UInt64)percentile(100);
+				return summary;
+			}
+		};
+
+		Histogram() {
+			for (std::atomic<uint64_t>& count : counts_)
+				count.store(0, std::memory_order_relaxed);
+		}
+		void record(clock::duration duration) {
+			const long long us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+			const uint64_t value = us > 0 ? (uint64_t)us : 0;
+			std::atomic<uint64_t>& count = counts_[bucket(value)];
+			count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			sum_us_.store(sum_us_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+		Snapshot snapshot() const {
+			Snapshot snapshot;
+			for (size_t i = 0; i < BUCKETS; i++)
+				snapshot.counts[i] = counts_[i].load(std::memory_order_relaxed);
+			snapshot.sum_us = sum_us_.load(std::memory_order_relaxed);
+			return snapshot;
+		}
+	private:
+		// Values below SUB_BUCKETS get a bucket each, above that the top 3 bits past the leading one pick the bucket
+		static size_t bucket(uint64_t value) {
+			if (value < SUB_BUCKETS)
+				return (size_t)value;
+			int magnitude = 0;
+			while ((value >> magnitude) >= 2 * SUB_BUCKETS)
+				magnitude++;
+			return std::min<size_t>((magnitude + 1) * SUB_BUCKETS + (size_t)((value >> magnitude) - SUB_BUCKETS), BUCKETS - 1);
+		}
+		static uint64_t upper_bound(size_t bucket) {
+			if (bucket < SUB_BUCKETS)
+				return bucket;
+			const size_t magnitude = bucket / SUB_BUCKETS - 1;
+			return ((SUB_BUCKETS + bucket % SUB_BUCKETS + 1) << magnitude) - 1;
+		}
+
+		std::array<std::atomic<uint64_t>, BUCKETS> counts_;
+		std::atomic<uint64_t> sum_us_{ 0 };
+	};
+
+	// What a device's frames went through on the way to OSVR, written from the update callback
+	struct DeviceMetrics {
+		Counter frames;	// New frames reported
+		Counter dropped;	// Frames PSMoveService sent that were overwritten before a report picked them up
+		Counter repeats;	// Ticks the device was attached but had nothing new
+		Counter idle;	// New frames not reported because the device was idle
+		Counter imu_samples;	// IMU samples reported
+		Counter imu_lost;	// IMU samples dropped because the ring was full or their frame was replaced, counted on the poll thread
+		Histogram latency;	// PSMoveService sampling the frame to the report
+		Histogram age;	// The frame reaching the poll thread to the report
+	};
+
+	// Where the time goes each tick, written from a group's update callback
+	struct ReportMetrics {
+		Counter ticks;
+		Counter calls;	// OSVR device calls issued
+		Histogram interval;	// Between reports
+		Histogram tick_cost;	// The whole update callback, minus waiting
+		Histogram convert;	// Pose transform and filter stages
+		Histogram send;	// Sending to OSVR
+	};
+
+	// Written from the poll thread
+	struct PollMetrics {
+		Counter polls;
+		Histogram psm_update;	// PSM_UpdateNoPollMessages
+	};
+	PollMetrics poll_metrics;
+
+	// A rigid transform from the config, position in meters
+	struct RigidTransform {
+		float position[3] = { 0, 0, 0 };
+		float orientation[4] = { 1, 0, 0, 0 };	// w, x, y, z
+	};
+
+	enum class FilterType { None, OneEuro, Adaptive };
+
+	// Pose smoothing from a device's "filter" config entry. A lower cutoff removes more jitter but
+	// lags more; speed raises the cutoff again so fast motion stays responsive.
+	struct FilterSettings {
+		FilterType type = FilterType::None;
+		double min_cutoff_hz = 1.0;	// Cutoff while holding still
+		double beta = 0.5;	// One Euro: how far the cutoff rises per m/s (or rad/s for orientation)
+		double d_cutoff_hz = 1.0;	// One Euro: cutoff of the speed estimate
+		double max_cutoff_hz = 20.0;	// Adaptive: cutoff at full_speed and above
+		double full_speed = 1.0;	// Adaptive: speed in m/s (or rad/s) at which max_cutoff_hz is reached
+	};
+
+	// Activity gating from an "idle" config entry. A device that stays within these thresholds of
+	// where it last moved, with no button or analog changes, for after_ms only reports its tracker
+	// at keepalive_hz, until it moves again.
+	struct IdleSettings {
+		bool enabled = false;
+		double position_m = 0.002;	// Movement that wakes the device
+		double rotation_deg = 1.0;	// Rotation that wakes the device
+		double after_ms = 500;	// How long the device has to stay still before it idles
+		double keepalive_hz = 5;	// Tracker report rate while idle
+	};
+
+	// Per-device options from the "controllers" config entry
+	struct DeviceSettings {
+		double prediction_ms = 0;	// How far ahead to extrapolate the pose using the physics data
+		unsigned int stream_flags = PSMStreamFlags_defaultStreamOptions;	// Which optional data PSMoveService streams for the device
+		RigidTransform offset;	// Applied in the device's own frame, e.g. from the tracked bulb to the grip
+		FilterSettings filter;
+		IdleSettings idle;
+	};
+
+	// Names for the PSMStreamFlags a device's "stream" config entry can list
+	const std::pair<const char*, unsigned int> STREAM_FLAG_NAMES[] = {
+		{ "position", PSMStreamFlags_includePositionData },
+		{ "physics", PSMStreamFlags_includePhysicsData },
+		{ "raw_sensor", PSMStreamFlags_includeRawSensorData },
+		{ "calibrated_sensor", PSMStreamFlags_includeCalibratedSensorData },
+		{ "raw_tracker", PSMStreamFlags_includeRawTrackerData }
+	};
+
+	// Turns a "stream" array into PSMStreamFlags, returns false on an unknown name
+	bool parse_stream_flags(const Json::Value& stream, unsigned int& flags, std::string& unknown) {
+		flags = PSMStreamFlags_defaultStreamOptions;
+		for (const Json::Value& entry : stream) {
+			const std::string name = entry.asString();
+			auto found = std::find_if(std::begin(STREAM_FLAG_NAMES), std::end(STREAM_FLAG_NAMES),
+				[&name](const std::pair<const char*, unsigned int>& flag) { return name == flag.first; });
+			if (found == std::end(STREAM_FLAG_NAMES)) {
+				unknown = name;
+				return false;
+			}
+			flags |= found->second;
+		}
+		return true;
+	}
+
+	// Where each device type keeps a button or analog value within its PSMoveService state
+	template <typename State>
+	struct ButtonChannel {
+		const char* name;
+		PSMButtonState State::*button;
+	};
+
+	template <typename State>
+	struct AnalogChannel {
+		const char* name;
+		double (*read)(const State& state);
+	};
+
+	// Tracking data of the last snapshot read from a tracked device
+	struct TrackedSample {
+		PSMPosef pose;
+		PSMPhysicsData physics;
+	};
+
+	// One calibrated accelerometer and gyroscope reading, from a frame with "calibrated_sensor" streamed
+	struct ImuSample {
+		double time;	// PSMoveService's timestamp for it, in seconds
+		OSVR_TimeValue received;	// When its frame reached the poll thread
+		float accelerometer[3];	// In g
+		float gyroscope[3];	// In rad/s
+	};
+
+	// Fixed size single producer, single consumer ring of IMU samples. The poll thread pushes every
+	// sample as its frame arrives and the device's ImuDevice drains them as they come, so none are lost
+	// to the triple buffer only holding the latest frame. If the callback falls too far behind the
+	// newest samples are dropped rather than overwriting ones it may be reading.
+	class ImuRing {
+	public:
+		static constexpr size_t CAPACITY = 256;
+
+		bool push(const ImuSample& sample) {
+			const size_t tail = tail_.load(std::memory_order_relaxed);
+			if (tail - head_.load(std::memory_order_acquire) == CAPACITY)
+				return false;
+			samples_[tail % CAPACITY] = sample;
+			tail_.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+		bool pop(ImuSample& sample) {
+			const size_t head = head_.load(std::memory_order_relaxed);
+			if (head == tail_.load(std::memory_order_acquire))
+				return false;
+			sample = samples_[head % CAPACITY];
+			head_.store(head + 1, std::memory_order_release);
+			return true;
+		}
+	private:
+		std::array<ImuSample, CAPACITY> samples_;
+		std::atomic<size_t> head_{ 0 };
+		std::atomic<size_t> tail_{ 0 };
+	};
+
+	// A sequence number going backwards or jumping further than this means PSMoveService restarted the stream
+	const int MAX_SEQUENCE_GAP = 1000;
+
+	// Producer side of a device: the poll thread publishes its frames here, and the update callback
+	// takes them through DeviceType::read, which keeps what it reads in the device's DeviceRecord.
+	class DeviceFeedBase {
+	public:
+		DeviceFeedBase(const DeviceSettings& device_settings):settings(device_settings) {};
+		virtual ~DeviceFeedBase() {};
+
+		const DeviceSettings settings;
+		// Called on the poll thread, publishes a new snapshot if PSMoveService delivered a new frame
+		virtual bool pump() = 0;
+		// Called on the poll thread (or during startup, before it exists) as the device comes and goes
+		virtual bool attached() const = 0;
+		// attach() returns PSMResult_RequestSent with the stream start request, PSMResult_Success when
+		// replaying, or the error PSMoveService refused the request with
+		virtual PSMResult attach(PSMRequestID* request) = 0;
+		virtual void detach() = 0;
+
+		// Called on the poll thread, true once the update callback has read the last frame published
+		bool consumed() const {
+			return consumed_.load(std::memory_order_acquire) == published_;
+		}
+		DeviceMetrics metrics;
+		// Called from the ImuDevice's update callback. Takes the oldest IMU sample not reported yet,
+		// and maps its time onto the local clock.
+		bool pop_imu(ImuSample& sample, OSVR_TimeValue& captured) {
+			if (!imu_.pop(sample))
+				return false;
+			captured = imu_clock_mapper_.map(sample.time, sample.received);
+			metrics.imu_samples.add();
+			return true;
+		}
+	protected:
+		// Poll thread side, queues a frame's IMU reading unless it is the one the last frame carried
+		template <typename SensorData>
+		void push_imu(const SensorData& sensor, const OSVR_TimeValue& received) {
+			if (sensor.TimeInSeconds > 0 && sensor.TimeInSeconds == last_imu_time_)
+				return;
+			last_imu_time_ = sensor.TimeInSeconds;
+			const ImuSample sample = {
+				sensor.TimeInSeconds, received,
+				{ sensor.Accelerometer.x, sensor.Accelerometer.y, sensor.Accelerometer.z },
+				{ sensor.Gyroscope.x, sensor.Gyroscope.y, sensor.Gyroscope.z }
+			};
+			if (!imu_.push(sample))
+				metrics.imu_lost.add();
+		}
+		// Poll thread side, counts the IMU samples of frames PSMoveService replaced before a poll saw them
+		void skip_imu(int skipped_frames) {
+			if (skipped_frames > 0 && skipped_frames < MAX_SEQUENCE_GAP)
+				metrics.imu_lost.add(skipped_frames);
+		}
+
+		// Poll thread side, numbers each frame as it is published
+		uint64_t next_publication() {
+			return ++published_;
+		}
+		// Consumer side, tells the poll thread a frame has been read
+		void acknowledge(uint64_t publication) {
+			consumed_.store(publication, std::memory_order_release);
+		}
+	private:
+		ImuRing imu_;
+		ClockMapper imu_clock_mapper_;	// The IMU samples' own, as they are mapped on the ImuDevice's thread
+		double last_imu_time_ = 0;
+		uint64_t published_ = 0;
+		std::atomic<uint64_t> consumed_{ 0 };
+	};
+
+	// Frames the poll thread publishes can be captured to a file and replayed in place of PSMoveService.
+	// The file is a RecordingHeader followed by records, each a RecordHeader and the device's raw
+	// PSMoveService state padded to 8 bytes. Records are only ever appended, and every one is self
+	// describing, so a recording can be memory-mapped and walked while it is still being written.
+	const char RECORDING_MAGIC[8] = { 'P', 'S', 'M', 'O', 'S', 'V', 'R', 'R' };
+	const uint32_t RECORDING_VERSION = 1;
+
+	struct RecordingHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t controller_size;	// sizeof(PSMController) and sizeof(PSMHeadMountedDisplay) when recorded, replay needs the same layout
+		uint32_t hmd_size;
+		uint32_t reserved;
+	};
+
+	struct RecordHeader {
+		double received;	// When the frame reached the poll thread, in seconds
+		int32_t id;
+		uint8_t hmd;
+		uint8_t connected;
+		uint16_t reserved;
+		uint32_t size;	// Padded size of the state that follows, 0 while disconnected
+		uint32_t reserved2;
+	};
+	static_assert(sizeof(RecordingHeader) == 24 && sizeof(RecordHeader) == 24, "Recording layout must not depend on the compiler");
+
+	// Appends published frames to a recording. The poll thread only copies them into memory; a
+	// writer thread moves them to disk, so a slow disk can't hold up polling.
+	class FrameRecorder {
+	public:
+		~FrameRecorder() {
+			if (!thread_.joinable())
+				return;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				running_ = false;
+			}
+			cv_.notify_one();
+			thread_.join();
+		}
+
+		bool open(const std::string& path) {
+			file_.open(path, std::ios::binary | std::ios::trunc);
+			if (!file_)
+				return false;
+			RecordingHeader header = {};
+			std::copy(std::begin(RECORDING_MAGIC), std::end(RECORDING_MAGIC), header.magic);
+			header.version = RECORDING_VERSION;
+			header.controller_size = sizeof(PSMController);
+			header.hmd_size = sizeof(PSMHeadMountedDisplay);
+			file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			thread_ = std::thread(&FrameRecorder::run, this);
+			return true;
+		}
+
+		// Called on the poll thread for every published frame
+		void write(bool hmd, int id, bool connected, const OSVR_TimeValue& received, const void* state, size_t size) {
+			RecordHeader header = {};
+			header.received = time_value_seconds(received);
+			header.id = id;
+			header.hmd = hmd;
+			header.connected = connected;
+			header.size = connected ? (uint32_t)((size + 7) & ~size_t(7)) : 0;
+			std::lock_guard<std::mutex> lock(mutex_);
+			const char* bytes = reinterpret_cast<const char*>(&header);
+			pending_.insert(pending_.end(), bytes, bytes + sizeof(header));
+			if (!connected)
+				return;
+			bytes = static_cast<const char*>(state);
+			pending_.insert(pending_.end(), bytes, bytes + size);
+			pending_.resize(pending_.size() + header.size - size, 0);
+		}
+
+	private:
+		void run() {
+			std::vector<char> writing;
+			std::unique_lock<std::mutex> lock(mutex_);
+			while (running_ || !pending_.empty()) {
+				cv_.wait_for(lock, FLUSH_INTERVAL, [this] { return !running_; });
+				writing.swap(pending_);
+				lock.unlock();
+				file_.write(writing.data(), writing.size());
+				file_.flush();
+				writing.clear();
+				lock.lock();
+			}
+		}
+
+		static constexpr std::chrono::milliseconds FLUSH_INTERVAL{ 100 };
+		std::ofstream file_;
+		std::mutex mutex_;
+		std::condition_variable cv_;
+		bool running_ = true;
+		std::vector<char> pending_;
+		std::thread thread_;
+	};
+
+	// Plays a recording back as if PSMoveService were streaming it. Each recorded device gets a
+	// PSMController or PSMHeadMountedDisplay the feeds attach to, just like PSM_GetController()
+	// and PSM_GetHmd(), and the poll thread advances the recording into them.
+	class FrameReplayer {
+	public:
+		bool load(const std::string& path, bool realtime, std::string& error) {
+			realtime_ = realtime;
+			std::ifstream file(path, std::ios::binary);
+			if (!file) {
+				error = "could not open it";
+				return false;
+			}
+			data_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+			RecordingHeader header;
+			if (data_.size() < sizeof(header)) {
+				error = "it is not a recording";
+				return false;
+			}
+			std::memcpy(&header, data_.data(), sizeof(header));
+			if (!std::equal(std::begin(RECORDING_MAGIC), std::end(RECORDING_MAGIC), header.magic) || header.version != RECORDING_VERSION) {
+				error = "it is not a recording, or from an incompatible version";
+				return false;
+			}
+			if (header.controller_size != sizeof(PSMController) || header.hmd_size != sizeof(PSMHeadMountedDisplay)) {
+				error = "it was recorded against a different PSMoveService client version";
+				return false;
+			}
+
+			// Check every record, and start each device out in the state of its first one
+			begin_ = offset_ = sizeof(header);
+			for (size_t offset = begin_; offset < data_.size(); ) {
+				RecordHeader record;
+				if (data_.size() - offset < sizeof(record)) {
+					error = "it is truncated";
+					return false;
+				}
+				std::memcpy(&record, data_.data() + offset, sizeof(record));
+				const size_t state_size = record.hmd ? sizeof(PSMHeadMountedDisplay) : sizeof(PSMController);
+				if ((record.size != 0 && record.size < state_size) || data_.size() - offset - sizeof(record) < record.size) {
+					error = "it is truncated";
+					return false;
+				}
+				if (offset == begin_)
+					first_received_ = record.received;
+				if (!find(record.hmd != 0, record.id)) {
+					slots_.emplace_back(new Slot());
+					slots_.back()->hmd = record.hmd != 0;
+					slots_.back()->id = record.id;
+					apply(record, data_.data() + offset + sizeof(record));
+				}
+				offset += sizeof(record) + record.size;
+			}
+			return true;
+		}
+
+		PSMController* controller(int id) {
+			Slot* slot = find(false, id);
+			return slot ? &slot->controller : nullptr;
+		}
+		PSMHeadMountedDisplay* hmd(int id) {
+			Slot* slot = find(true, id);
+			return slot ? &slot->hmd_state : nullptr;
+		}
+		bool connected(bool hmd, int id) {
+			Slot* slot = find(hmd, id);
+			return slot && slot->connected;
+		}
+
+		// The devices connected at this point in the recording, like PSM_GetControllerList() and PSM_GetHmdList()
+		void device_lists(PSMControllerList& controllers, PSMHmdList& hmds) const {
+			controllers.count = 0;
+			hmds.count = 0;
+			for (const std::unique_ptr<Slot>& slot : slots_) {
+				if (!slot->connected)
+					continue;
+				if (slot->hmd && hmds.count < PSMOVESERVICE_MAX_HMD_COUNT) {
+					hmds.hmd_id[hmds.count] = slot->id;
+					hmds.hmd_type[hmds.count++] = slot->hmd_state.HmdType;
+				}
+				else if (!slot->hmd && controllers.count < PSMOVESERVICE_MAX_CONTROLLER_COUNT) {
+					controllers.controller_id[controllers.count] = slot->id;
+					controllers.controller_type[controllers.count++] = slot->controller.ControllerType;
+				}
+			}
+		}
+
+		// Applies the records that are due: at real-time speed those recorded up to as long after the
+		// first one as replay has been running, otherwise just the next one. Returns true if any were.
+		bool advance(clock::time_point now) {
+			if (!started_) {
+				started_ = true;
+				start_ = now;
+			}
+			const double elapsed = std::chrono::duration<double>(now - start_).count();
+			bool applied = false;
+			while (offset_ < data_.size()) {
+				RecordHeader record;
+				std::memcpy(&record, data_.data() + offset_, sizeof(record));
+				if (realtime_ && record.received - first_received_ > elapsed)
+					break;
+				apply(record, data_.data() + offset_ + sizeof(record));
+				offset_ += sizeof(record) + record.size;
+				applied = true;
+				if (!realtime_)
+					break;
+			}
+			return applied;
+		}
+		bool finished() const {
+			return offset_ >= data_.size();
+		}
+		bool realtime() const {
+			return realtime_;
+		}
+
+	private:
+		struct Slot {
+			bool hmd = false;
+			int id = 0;
+			bool connected = false;
+			PSMController controller = {};
+			PSMHeadMountedDisplay hmd_state = {};
+		};
+
+		Slot* find(bool hmd, int id) {
+			for (const std::unique_ptr<Slot>& slot : slots_) {
+				if (slot->hmd == hmd && slot->id == id)
+					return slot.get();
+			}
+			return nullptr;
+		}
+		void apply(const RecordHeader& record, const char* state) {
+			Slot* slot = find(record.hmd != 0, record.id);
+			slot->connected = record.connected != 0;
+			if (!slot->connected)
+				return;
+			if (slot->hmd)
+				std::memcpy(&slot->hmd_state, state, sizeof(PSMHeadMountedDisplay));
+			else
+				std::memcpy(&slot->controller, state, sizeof(PSMController));
+		}
+
+		std::vector<char> data_;
+		size_t begin_ = 0;
+		size_t offset_ = 0;
+		double first_received_ = 0;
+		bool realtime_ = true;
+		bool started_ = false;
+		clock::time_point start_;
+		// Feeds hold pointers into the slots, so they never move
+		std::vector<std::unique_ptr<Slot>> slots_;
+	};
+
+	// Set from the "replay" config entry, otherwise null. The recorder for "record" belongs to the
+	// PluginRuntime, as its writer thread has to be stopped when the plugin is, not at exit.
+	std::unique_ptr<FrameReplayer> frame_replayer;
+
+	// Attaches to a device on PSMoveService and asks for its data stream to start, without waiting for the answer.
+	// When replaying, the device's state comes from the recording instead.
+	template <typename Source>
+	Source* start_device_stream(int id, unsigned int stream_flags, PSMRequestID* request, PSMResult& result);
+
+	template <>
+	PSMController* start_device_stream<PSMController>(int id, unsigned int stream_flags, PSMRequestID* request, PSMResult& result) {
+		result = PSMResult_Success;
+		if (frame_replayer)
+			return frame_replayer->controller(id);
+		PSMController* controller = PSM_GetController(id);
+		PSM_AllocateControllerListener(id);
+		result = PSM_StartControllerDataStreamAsync(id, stream_flags, request);
+		return controller;
+	}
+
+	template <>
+	PSMHeadMountedDisplay* start_device_stream<PSMHeadMountedDisplay>(int id, unsigned int stream_flags, PSMRequestID* request, PSMResult& result) {
+		result = PSMResult_Success;
+		if (frame_replayer)
+			return frame_replayer->hmd(id);
+		PSMHeadMountedDisplay* hmd = PSM_GetHmd(id);
+		PSM_AllocateHmdListener(id);
+		result = PSM_StartHmdDataStreamAsync(id, stream_flags, request);
+		return hmd;
+	}
+
+	// Stops a device's data stream and releases it, so it can be attached again when it reconnects
+	template <typename Source>
+	void stop_device_stream(int id);
+
+	template <>
+	void stop_device_stream<PSMController>(int id) {
+		if (frame_replayer)
+			return;
+		PSMRequestID request;
+		PSM_StopControllerDataStreamAsync(id, &request);
+		PSM_FreeControllerListener(id);
+	}
+
+	template <>
+	void stop_device_stream<PSMHeadMountedDisplay>(int id) {
+		if (frame_replayer)
+			return;
+		PSMRequestID request;
+		PSM_StopHmdDataStreamAsync(id, &request);
+		PSM_FreeHmdListener(id);
+	}
+
+	// Hands the state of one PSMoveService device from the poll thread to the OSVR update callback.
+	// Traits is one of the device type descriptions below. The feed exists for every configured
+	// device; it is attached to PSMoveService while the device is connected and detached otherwise.
+	template <typename Traits>
+	class DeviceFeed : public DeviceFeedBase {
+	public:
+		typedef typename Traits::Source Source;
+		typedef typename Traits::State State;
+
+		DeviceFeed(int id, const DeviceSettings& settings, FrameRecorder* recorder):DeviceFeedBase(settings), id_(id), recorder_(recorder) {};
+		bool attached() const override {
+			return source_ != nullptr;
+		}
+		PSMResult attach(PSMRequestID* request) override {
+			PSMResult result;
+			source_ = start_device_stream<Source>(id_, settings.stream_flags, request, result);
+			seen_sequence_ = source_->OutputSequenceNum;
+			publish();
+			return result;
+		}
+		void detach() override {
+			stop_device_stream<Source>(id_);
+			source_ = nullptr;
+			publish();
+		}
+		bool pump() override {
+			if (!source_ || source_->OutputSequenceNum == seen_sequence_)
+				return false;
+			if constexpr (Traits::IMU) {
+				if (settings.stream_flags & PSMStreamFlags_includeCalibratedSensorData)
+					skip_imu(source_->OutputSequenceNum - seen_sequence_ - 1);
+			}
+			seen_sequence_ = source_->OutputSequenceNum;
+			publish();
+			return true;
+		}
+		struct Frame {
+			Source state;
+			OSVR_TimeValue received;
+			uint64_t publication;
+			bool connected;
+		};
+
+		// Called from the update callback, takes the latest frame and tells the poll thread it was read
+		const Frame& take() {
+			const Frame& frame = buffer_.front();
+			acknowledge(frame.publication);
+			return frame;
+		}
+	private:
+		// Poll thread side, snapshots the source, or marks the device disconnected if there is none
+		void publish() {
+			Frame& frame = buffer_.back();
+			frame.publication = next_publication();
+			frame.connected = (source_ != nullptr);
+			if (source_)
+				frame.state = *source_;
+			osvrTimeValueGetNow(&frame.received);
+			if constexpr (Traits::IMU) {
+				if (source_ && (settings.stream_flags & PSMStreamFlags_includeCalibratedSensorData))
+					push_imu(Traits::state(frame.state).CalibratedSensorData, frame.received);
+			}
+			if (recorder_)
+				recorder_->write(std::is_same<Source, PSMHeadMountedDisplay>::value, id_, frame.connected, frame.received, &frame.state, sizeof(Source));
+			buffer_.publish();
+		}
+
+		const int id_;
+		FrameRecorder* const recorder_;	// Null unless recording
+		Source* source_ = nullptr;
+		int seen_sequence_ = 0;
+		TripleBuffer<Frame> buffer_;
+	};
+
+	// Analog channels are reported on a 0-255 scale
+	double unit_to_analog(float value) {
+		return (double)(int)(255 * value);
+	}
+	double axis_to_analog(float value) {
+		return (double)(int)(255 * (value + 1) / 2);
+	}
+
+	// What tracked devices stream by default: only what the reporting path reads, the pose, and
+	// physics for derivatives, prediction and timestamps
+	constexpr unsigned int TRACKED_STREAM_FLAGS = PSMStreamFlags_includePositionData | PSMStreamFlags_includePhysicsData;
+
+	// Compile-time description of each supported PSMoveService device type. The channel layout, the
+	// JSON descriptor, config validation and the per-tick extraction are all generated from these,
+	// so adding a device type means adding one struct here and listing it in device_types().
+	struct MoveTraits {
+		typedef PSMController Source;
+		typedef PSMPSMove State;
+		static constexpr const char* TYPE_NAME = "Move";
+		static constexpr const char* DESCRIPTION = "Move controller";
+		static constexpr int PSM_TYPE = PSMController_Move;
+		static constexpr bool TRACKED = true;
+		static constexpr bool IMU = true;	// Has calibrated accelerometer and gyroscope data to stream
+		static constexpr unsigned int STREAM_FLAGS = TRACKED_STREAM_FLAGS;
+		static const State& state(const Source& source) {
+			return source.ControllerState.PSMoveState;
+		}
+		static constexpr std::array<ButtonChannel<State>, 9> BUTTONS = { {
+			{ "/triangle", &State::TriangleButton },
+			{ "/circle", &State::CircleButton },
+			{ "/cross", &State::CrossButton },
+			{ "/square", &State::SquareButton },
+			{ "/select", &State::SelectButton },
+			{ "/start", &State::StartButton },
+			{ "/ps", &State::PSButton },
+			{ "/move", &State::MoveButton },
+			{ "/triggerbtn", &State::TriggerButton }
+		} };
+		static constexpr std::array<AnalogChannel<State>, 1> ANALOGS = { {
+			{ "/trigger", [](const State& state) -> double { return state.TriggerValue; } }
+		} };
+	};
+
+	struct NaviTraits {
+		typedef PSMController Source;
+		typedef PSMPSNavi State;
+		static constexpr const char* TYPE_NAME = "Navi";
+		static constexpr const char* DESCRIPTION = "Navigation controller";
+		static constexpr int PSM_TYPE = PSMController_Navi;
+		static constexpr bool TRACKED = false;
+		static constexpr bool IMU = false;
+		// Buttons and analogs are always streamed, the Navi has nothing optional we use
+		static constexpr unsigned int STREAM_FLAGS = PSMStreamFlags_defaultStreamOptions;
+		static const State& state(const Source& source) {
+			return source.ControllerState.PSNaviState;
+		}
+		static constexpr std::array<ButtonChannel<State>, 11> BUTTONS = { {
+			{ "/l1", &State::L1Button },
+			{ "/l2", &State::L2Button },
+			{ "/l3", &State::L3Button },
+			{ "/circle", &State::CircleButton },
+			{ "/cross", &State::CrossButton },
+			{ "/ps", &State::PSButton },
+			{ "/triggerbtn", &State::TriggerButton },
+			{ "/dpadup", &State::DPadUpButton },
+			{ "/dpadright", &State::DPadRightButton },
+			{ "/dpaddown", &State::DPadDownButton },
+			{ "/dpadleft", &State::DPadLeftButton }
+		} };
+		static constexpr std::array<AnalogChannel<State>, 3> ANALOGS = { {
+			{ "/trigger", [](const State& state) -> double { return state.TriggerValue; } },
+			{ "/stickx", [](const State& state) -> double { return state.Stick_XAxis; } },
+			{ "/sticky", [](const State& state) -> double { return state.Stick_YAxis; } }
+		} };
+	};
+
+	struct DualShock4Traits {
+		typedef PSMController Source;
+		typedef PSMDualShock4 State;
+		static constexpr const char* TYPE_NAME = "DualShock4";
+		static constexpr const char* DESCRIPTION = "DualShock4 controller";
+		static constexpr int PSM_TYPE = PSMController_DualShock4;
+		static constexpr bool TRACKED = true;
+		static constexpr bool IMU = true;
+		static constexpr unsigned int STREAM_FLAGS = TRACKED_STREAM_FLAGS;
+		static const State& state(const Source& source) {
+			return source.ControllerState.PSDS4State;
+		}
+		static constexpr std::array<ButtonChannel<State>, 18> BUTTONS = { {
+			{ "/dpadup", &State::DPadUpButton },
+			{ "/dpaddown", &State::DPadDownButton },
+			{ "/dpadleft", &State::DPadLeftButton },
+			{ "/dpadright", &State::DPadRightButton },
+			{ "/square", &State::SquareButton },
+			{ "/cross", &State::CrossButton },
+			{ "/circle", &State::CircleButton },
+			{ "/triangle", &State::TriangleButton },
+			{ "/l1", &State::L1Button },
+			{ "/r1", &State::R1Button },
+			{ "/l2", &State::L2Button },
+			{ "/r2", &State::R2Button },
+			{ "/l3", &State::L3Button },
+			{ "/r3", &State::R3Button },
+			{ "/share", &State::ShareButton },
+			{ "/options", &State::OptionsButton },
+			{ "/ps", &State::PSButton },
+			{ "/trackpad", &State::TrackPadButton }
+		} };
+		static constexpr std::array<AnalogChannel<State>, 6> ANALOGS = { {
+			{ "/lstickx", [](const State& state) { return axis_to_analog(state.LeftAnalogX); } },
+			{ "/lsticky", [](const State& state) { return axis_to_analog(state.LeftAnalogY); } },
+			{ "/rstickx", [](const State& state) { return axis_to_analog(state.RightAnalogX); } },
+			{ "/rsticky", [](const State& state) { return axis_to_analog(state.RightAnalogY); } },
+			{ "/ltrigger", [](const State& state) { return unit_to_analog(state.LeftTriggerValue); } },
+			{ "/rtrigger", [](const State& state) { return unit_to_analog(state.RightTriggerValue); } }
+		} };
+	};
+
+	struct VirtualMoveTraits {
+		typedef PSMController Source;
+		typedef PSMVirtualController State;
+		static constexpr const char* TYPE_NAME = "VirtualMove";
+		static constexpr const char* DESCRIPTION = "VirtualMove controller";
+		static constexpr int PSM_TYPE = PSMController_Virtual;
+		static constexpr bool TRACKED = true;
+		static constexpr bool IMU = false;
+		static constexpr unsigned int STREAM_FLAGS = TRACKED_STREAM_FLAGS;
+		static const State& state(const Source& source) {
+			return source.ControllerState.VirtualController;
+		}
+		// TODO: Do virtual controllers have buttons & analog inputs ?
+		static constexpr std::array<ButtonChannel<State>, 0> BUTTONS = {};
+		static constexpr std::array<AnalogChannel<State>, 0> ANALOGS = {};
+	};
+
+	struct VirtualHmdTraits {
+		typedef PSMHeadMountedDisplay Source;
+		typedef PSMVirtualHMD State;
+		static constexpr const char* TYPE_NAME = "VirtualHMD";
+		static constexpr const char* DESCRIPTION = "VirtualHMD HMD";
+		static constexpr int PSM_TYPE = PSMHmd_Virtual;
+		static constexpr bool TRACKED = true;
+		static constexpr bool IMU = false;
+		static constexpr unsigned int STREAM_FLAGS = TRACKED_STREAM_FLAGS;
+		static const State& state(const Source& source) {
+			return source.HmdState.VirtualHMDState;
+		}
+		static constexpr std::array<ButtonChannel<State>, 0> BUTTONS = {};
+		static constexpr std::array<AnalogChannel<State>, 0> ANALOGS = {};
+	};
+
+	struct PsvrTraits {
+		typedef PSMHeadMountedDisplay Source;
+		typedef PSMMorpheus State;
+		static constexpr const char* TYPE_NAME = "PSVR";
+		static constexpr const char* DESCRIPTION = "PSVR HMD";
+		static constexpr int PSM_TYPE = PSMHmd_Morpheus;
+		static constexpr bool TRACKED = true;
+		static constexpr bool IMU = true;
+		static constexpr unsigned int STREAM_FLAGS = TRACKED_STREAM_FLAGS;
+		static const State& state(const Source& source) {
+			return source.HmdState.MorpheusState;
+		}
+		static constexpr std::array<ButtonChannel<State>, 0> BUTTONS = {};
+		static constexpr std::array<AnalogChannel<State>, 0> ANALOGS = {};
+	};
+
+	struct DeviceType;
+
+	// One configured device, with its OSVR channel offsets within its group precomputed. Its group's
+	// update callback walks these in order every tick, so what it reads from the device each tick is
+	// kept here as well, next to the offsets, rather than behind the feed.
+	struct DeviceRecord {
+		std::string name;
+		int id;
+		const DeviceType* type;
+		std::unique_ptr<DeviceFeedBase> feed;
+		size_t group;
+		bool imu;	// Reports every IMU sample through an ImuDevice of its own
+		OSVR_ChannelCount tracker;
+		OSVR_ChannelCount first_button;
+		OSVR_ChannelCount first_analog;
+
+		// Consumer side, only touched from the group's update callback
+		TrackedSample sample = {};	// Tracking data of the last frame read()
+		OSVR_TimeValue received = {};	// When the frame from the last read() reached the poll thread
+		int sequence = 0;	// PSMoveService's sequence number of the last frame reported
+		bool reported_any = false;
+		bool new_frame = false;	// The last read() took a frame not reported before
+		bool connected = false;	// False while the device is detached from PSMoveService
+		bool stale = false;	// No new frame for longer than stale_timeout
+		clock::time_point last_frame_time = clock::now();
+		ClockMapper clock_mapper;
+
+		// When PSMoveService sampled the frame, on the local clock, given its own timestamp for it
+		OSVR_TimeValue captured(double sample_seconds) {
+			return clock_mapper.map(sample_seconds, received);
+		}
+		// Times from PSMoveService sampling the frame, and from it reaching the poll thread, to it being reported
+		void record_latency(const OSVR_TimeValue& captured, const OSVR_TimeValue& reported) {
+			if (!metrics_enabled)
+				return;
+			const double reported_seconds = time_value_seconds(reported);
+			feed->metrics.latency.record(std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(reported_seconds - time_value_seconds(captured))));
+			feed->metrics.age.record(std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(reported_seconds - time_value_seconds(received))));
+		}
+		// Re-evaluates whether the device has gone quiet for longer than timeout, returns true if that changed
+		bool update_stale(clock::time_point now, clock::duration timeout) {
+			const bool quiet = (now - last_frame_time) > timeout;
+			if (quiet == stale)
+				return false;
+			stale = quiet;
+			return true;
+		}
+		// Notes a frame read from the attached device, and whether it is one not reported before
+		void track_sequence(int frame_sequence, const OSVR_TimeValue& frame_received, clock::time_point now) {
+			connected = true;
+			received = frame_received;
+			new_frame = !reported_any || frame_sequence != sequence;
+			if (!new_frame) {
+				feed->metrics.repeats.add();
+				return;
+			}
+			const int skipped = frame_sequence - sequence - 1;
+			if (reported_any && skipped > 0 && skipped < MAX_SEQUENCE_GAP)
+				feed->metrics.dropped.add(skipped);
+			feed->metrics.frames.add();
+			reported_any = true;
+			sequence = frame_sequence;
+			last_frame_time = now;
+		}
+	};
+
+	// Called through DeviceType::read from the update callback once per tick. Takes the device's
+	// latest frame, writes its button and analog values to the given channel slots and keeps its
+	// tracking data in the record. A detached device's slots read as released and zero.
+	template <typename Traits>
+	void read_device(DeviceRecord& device, clock::time_point now, OSVR_ButtonState* buttons, OSVR_AnalogState* analogs) {
+		typedef typename Traits::State State;
+		const auto& frame = static_cast<DeviceFeed<Traits>&>(*device.feed).take();
+		if (!frame.connected) {
+			std::fill_n(buttons, Traits::BUTTONS.size(), OSVR_BUTTON_NOT_PRESSED);
+			std::fill_n(analogs, Traits::ANALOGS.size(), 0.0);
+			device.new_frame = false;
+			device.connected = false;
+			return;
+		}
+		device.track_sequence(frame.state.OutputSequenceNum, frame.received, now);
+		const State& state = Traits::state(frame.state);
+		for (const ButtonChannel<State>& channel : Traits::BUTTONS)
+			*buttons++ = (state.*channel.button == PSMButtonState_DOWN) ? OSVR_BUTTON_PRESSED : OSVR_BUTTON_NOT_PRESSED;
+		for (const AnalogChannel<State>& channel : Traits::ANALOGS)
+			*analogs++ = channel.read(state);
+		if constexpr (Traits::TRACKED) {
+			device.sample.pose = state.Pose;
+			device.sample.physics = state.PhysicsData;
+		}
+	}
+
+	// Runtime view of a device type's traits, used wherever the type is only known from the config
+	struct DeviceType {
+		std::string type_name;
+		std::string description;
+		bool hmd;
+		int psm_type;
+		bool tracked;
+		bool imu;
+		unsigned int stream_flags;
+		std::vector<std::string> button_names;
+		std::vector<std::string> analog_names;
+		std::unique_ptr<DeviceFeedBase> (*make_feed)(int id, const DeviceSettings& settings, FrameRecorder* recorder);
+		void (*read)(DeviceRecord& device, clock::time_point now, OSVR_ButtonState* buttons, OSVR_AnalogState* analogs);
+	};
+
+	template <typename Traits>
+	DeviceType describe_device_type() {
+		DeviceType type;
+		type.type_name = Traits::TYPE_NAME;
+		type.description = Traits::DESCRIPTION;
+		type.hmd = std::is_same<typename Traits::Source, PSMHeadMountedDisplay>::value;
+		type.psm_type = Traits::PSM_TYPE;
+		type.tracked = Traits::TRACKED;
+		type.imu = Traits::IMU;
+		type.stream_flags = Traits::STREAM_FLAGS;
+		for (auto& channel : Traits::BUTTONS)
+			type.button_names.push_back(channel.name);
+		for (auto& channel : Traits::ANALOGS)
+			type.analog_names.push_back(channel.name);
+		type.make_feed = [](int id, const DeviceSettings& settings, FrameRecorder* recorder) -> std::unique_ptr<DeviceFeedBase> {
+			return std::unique_ptr<DeviceFeedBase>(new DeviceFeed<Traits>(id, settings, recorder));
+		};
+		type.read = &read_device<Traits>;
+		return type;
+	}
+
+	// Every supported device type. Channels are numbered in this order, grouped by type.
+	const std::vector<DeviceType>& device_types() {
+		static const std::vector<DeviceType> types = {
+			describe_device_type<MoveTraits>(),
+			describe_device_type<NaviTraits>(),
+			describe_device_type<DualShock4Traits>(),
+			describe_device_type<VirtualMoveTraits>(),
+			describe_device_type<VirtualHmdTraits>(),
+			describe_device_type<PsvrTraits>()
+		};
+		return types;
+	}
+
+	const DeviceType* find_device_type(const std::string& type_name) {
+		for (const DeviceType& type : device_types()) {
+			if (type.type_name == type_name)
+				return &type;
+		}
+		return nullptr;
+	}
+
+	// Analog channels of the ImuDevice of a device with "calibrated_sensor" streamed, accelerometer
+	// in g then gyroscope in rad/s. The OSVR device is named after the device with IMU_DEVICE_SUFFIX.
+	const char* const IMU_CHANNEL_NAMES[] = { "imu/accelx", "imu/accely", "imu/accelz", "imu/gyrox", "imu/gyroy", "imu/gyroz" };
+	const size_t IMU_CHANNELS = 6;
+	const std::string IMU_DEVICE_SUFFIX = "_imu";
+
+	// How MoveDevice::update() paces itself
+	enum class UpdateMode {
+		Fixed,	// Report once per period, whether or not new data arrived
+		Event	// Report as soon as any device has a new frame, or at the period deadline
+	};
+
+	// Devices reported through one OSVR device, with its own update thread and pace. Devices without
+	// a "group" go in the first one, which is named DEVICE_NAME and paced by the top level settings.
+	struct DeviceGroup {
+		std::string name;
+		UpdateMode mode = UpdateMode::Fixed;
+		double rate_hz = 100.0;
+		std::vector<DeviceRecord*> devices;
+		OSVR_ChannelCount num_trackers = 0;
+		OSVR_ChannelCount num_buttons = 0;
+		OSVR_ChannelCount num_analogs = 0;
+		ReportMetrics metrics;
+	};
+
 	const std::string DEVICE_NAME = "MoveDevice";
-	std::vector<std::pair<std::string, PSMController*>> move_controllers;
-	std::vector<std::pair<std::string, PSMController*>> navi_controllers;
-	std::vector<std::pair<std::string, PSMController*>> ds4_controllers;
-	std::vector<std::pair<std::string, PSMController*>> virtual_controllers;
-	std::vector<std::pair<std::string, PSMHeadMountedDisplay*>> virtual_hmds;
-	std::vector<std::pair<std::string, PSMHeadMountedDisplay*>> psvr_hmds;
+	std::vector<DeviceRecord> devices;
+	std::vector<std::unique_ptr<DeviceGroup>> groups;
 	bool display_json = false;
 
+	// Orders devices by group and type, and lays out their tracker, button and analog channels within each group
+	void assign_channels() {
+		std::stable_sort(devices.begin(), devices.end(), [](const DeviceRecord& a, const DeviceRecord& b) {
+			return a.group != b.group ? a.group < b.group : a.type < b.type;
+		});
+		for (std::unique_ptr<DeviceGroup>& group : groups) {
+			group->devices.clear();
+			group->num_trackers = group->num_buttons = group->num_analogs = 0;
+		}
+		for (DeviceRecord& device : devices) {
+			DeviceGroup& group = *groups[device.group];
+			group.devices.push_back(&device);
+			device.tracker = device.type->tracked ? group.num_trackers++ : 0;
+			device.first_button = group.num_buttons;
+			device.first_analog = group.num_analogs;
+			group.num_buttons += device.type->button_names.size();
+			group.num_analogs += device.type->analog_names.size();
+		}
+	}
+
+	// The latest state of every device can also be exported to a named shared memory region, for
+	// tools on the same machine that don't want to go through the OSVR server. The region is an
+	// ExportHeader followed by one ExportSlot per configured device, in the order of "devices".
+	// Each slot is a seqlock: its sequence is odd while the slot is being written, so a reader
+	// copies the slot between two reads of the sequence and retries if they differ or are odd.
+	const char EXPORT_MAGIC[8] = { 'P', 'S', 'M', 'O', 'S', 'V', 'R', 'S' };
+	const uint32_t EXPORT_VERSION = 1;
+
+	struct ExportHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t header_size;	// Where the first slot starts
+		uint32_t slot_size;
+		uint32_t slot_count;
+		uint64_t reserved;
+	};
+
+	enum ExportFlags : uint32_t {
+		EXPORT_CONNECTED = 1,	// The device is attached to PSMoveService
+		EXPORT_TRACKED = 2,	// The slot holds a pose
+		EXPORT_PHYSICS = 4	// The slot holds velocities
+	};
+
+	struct ExportSlot {
+		std::atomic<uint32_t> sequence;
+		uint32_t flags;	// ExportFlags
+		char path[80];	// The device's OSVR path, e.g. /inf_osvr_move/MoveDevice/semantic/controller1, null terminated
+		double sample_time;	// When PSMoveService sampled the pose plus any prediction, in seconds on the OSVR clock
+		double position[3];	// Meters, in the OSVR room, as reported to OSVR
+		double orientation[4];	// w, x, y, z
+		double linear_velocity[3];	// m/s
+		double angular_velocity[3];	// rad/s, about the world axes
+		uint64_t frames;	// Poses written so far
+		uint32_t buttons;	// Bit j is the device's button j
+		uint32_t analog_count;
+		float analogs[8];
+		uint8_t reserved[8];
+	};
+	static_assert(sizeof(ExportHeader) == 32 && sizeof(ExportSlot) == 256, "Export layout must not depend on the compiler");
+	static_assert(sizeof(std::atomic<uint32_t>) == 4 && ATOMIC_INT_LOCK_FREE == 2, "Export sequence must be a lock free 32 bit atomic");
+
+	// Owns the mapping. Every slot is written by the update thread of the device's group only.
+	class PoseExport {
+	public:
+		~PoseExport() {
+#ifdef _WIN32
+			if (view_)
+				UnmapViewOfFile(view_);
+			if (mapping_)
+				CloseHandle(mapping_);
+#else
+			if (view_)
+				munmap(view_, size_);
+			if (!name_.empty())
+				shm_unlink(name_.c_str());
+#endif
+		}
+
+		bool open(const std::string& name, size_t slot_count, std::string& error) {
+			size_ = sizeof(ExportHeader) + slot_count * sizeof(ExportSlot);
+#ifdef _WIN32
+			mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)size_, name.c_str());
+			if (!mapping_) {
+				error = "CreateFileMapping failed with error " + std::to_string(GetLastError());
+				return false;
+			}
+			view_ = MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size_);
+			if (!view_) {
+				error = "MapViewOfFile failed with error " + std::to_string(GetLastError());
+				return false;
+			}
+#else
+			name_ = name[0] == '/' ? name : "/" + name;
+			int fd = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0644);
+			if (fd < 0) {
+				error = std::string("shm_open failed, ") + std::strerror(errno);
+				name_.clear();
+				return false;
+			}
+			void* view = ftruncate(fd, (off_t)size_) == 0 ? mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+			if (view == MAP_FAILED)
+				error = std::string("mapping it failed, ") + std::strerror(errno);
+			close(fd);
+			if (view == MAP_FAILED)
+				return false;
+			view_ = view;
+#endif
+			// A region left over from an earlier run may still be mapped by readers, so bump its
+			// sequences rather than zeroing them, and hide it while the layout is rewritten
+			ExportHeader* header = static_cast<ExportHeader*>(view_);
+			std::memset(header->magic, 0, sizeof(header->magic));
+			header->version = EXPORT_VERSION;
+			header->header_size = sizeof(ExportHeader);
+			header->slot_size = sizeof(ExportSlot);
+			header->slot_count = (uint32_t)slot_count;
+			slots_ = reinterpret_cast<ExportSlot*>(static_cast<char*>(view_) + sizeof(ExportHeader));
+			for (size_t i = 0; i < slot_count; i++) {
+				ExportSlot& slot = slots_[i];
+				const uint32_t sequence = (slot.sequence.load(std::memory_order_relaxed) + 2) & ~1u;
+				std::memset(reinterpret_cast<char*>(&slot) + sizeof(slot.sequence), 0, sizeof(slot) - sizeof(slot.sequence));
+				slot.sequence.store(sequence, std::memory_order_relaxed);
+			}
+			std::atomic_thread_fence(std::memory_order_release);
+			std::copy(std::begin(EXPORT_MAGIC), std::end(EXPORT_MAGIC), header->magic);
+			return true;
+		}
+
+		// Only used while setting up, before any update thread runs
+		void set_path(size_t index, const std::string& path) {
+			ExportSlot& slot = slots_[index];
+			const size_t length = std::min(path.size(), sizeof(slot.path) - 1);
+			std::memcpy(slot.path, path.data(), length);
+			slot.path[length] = 0;
+		}
+
+		// Writers bracket every change to a slot with these
+		ExportSlot& begin_write(size_t index) {
+			ExportSlot& slot = slots_[index];
+			slot.sequence.store(slot.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			return slot;
+		}
+		void end_write(ExportSlot& slot) {
+			slot.sequence.store(slot.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+	private:
+#ifdef _WIN32
+		HANDLE mapping_ = nullptr;
+#else
+		std::string name_;
+#endif
+		void* view_ = nullptr;
+		size_t size_ = 0;
+		ExportSlot* slots_ = nullptr;
+	};
+
+	std::unique_ptr<PoseExport> pose_export;
+
+	// A device that delivers no new frame for this long is reported as stale
+	clock::duration stale_timeout = std::chrono::milliseconds(500);
+
+	// How often metrics are summarized, and the file they are appended to if any
+	clock::duration metrics_interval = std::chrono::seconds(10);
+	std::string metrics_file;
+
+	// Where PSMoveService runs. The client library holds a single connection per process.
+	std::string server_address = PSMOVESERVICE_DEFAULT_ADDRESS;
+	std::string server_port = PSMOVESERVICE_DEFAULT_PORT;
+
+	// Startup has to finish within this, however many devices there are
+	clock::duration startup_timeout = std::chrono::seconds(10);
+
+	// Delay between connection attempts, doubling after each failure
+	const std::chrono::milliseconds CONNECT_BACKOFF_MIN(100);
+	const std::chrono::milliseconds CONNECT_BACKOFF_MAX(2000);
+
+	// If attached devices deliver nothing at all for this long, the connection to PSMoveService is treated as lost
+	clock::duration watchdog_timeout = std::chrono::seconds(2);
+
+	// How often the poll thread re-checks which devices are connected, even if PSMoveService didn't say the lists changed
+	const std::chrono::seconds HOTPLUG_RESCAN_INTERVAL(2);
+
+	// How long the poll thread waits for PSMoveService to answer a stream start before giving up on it
+	const std::chrono::seconds STREAM_START_TIMEOUT(1);
+
+	// How often the poll thread asks PSMoveService for new data
+	const std::chrono::milliseconds POLL_INTERVAL(1);
+
+	// Interval the incremental rotations in velocity and acceleration reports are expressed over
+	const double INCREMENTAL_ROTATION_DT = 0.01;
+
+	// PSMoveService reports positions in centimeters, OSVR wants meters
+	float unit_scale = 0.01f;
+
+	// Moves the PSMoveService tracking space into the OSVR room
+	RigidTransform room_alignment;
+
 	std::string psm_error_str(PSMResult result) {
 		switch (result) {
 		case PSMResult_Canceled:
@@ -37,9 +1383,681 @@ namespace
 		}
 	}
 
+	// Lane types for the pose transform kernel below: one float at a time, or four at a time with SSE
+	struct ScalarLane {
+		static const size_t WIDTH = 1;
+		float v;
+		static ScalarLane load(const float* p) { return { *p }; }
+		static ScalarLane set(float x) { return { x }; }
+		void store(float* p) const { *p = v; }
+	};
+	inline ScalarLane operator+(ScalarLane a, ScalarLane b) { return { a.v + b.v }; }
+	inline ScalarLane operator-(ScalarLane a, ScalarLane b) { return { a.v - b.v }; }
+	inline ScalarLane operator*(ScalarLane a, ScalarLane b) { return { a.v * b.v }; }
+
+#if POSE_BATCH_SSE
+	struct SseLane {
+		static const size_t WIDTH = 4;
+		__m128 v;
+		static SseLane load(const float* p) { return { _mm_loadu_ps(p) }; }
+		static SseLane set(float x) { return { _mm_set1_ps(x) }; }
+		void store(float* p) const { _mm_storeu_ps(p, v); }
+	};
+	inline SseLane operator+(SseLane a, SseLane b) { return { _mm_add_ps(a.v, b.v) }; }
+	inline SseLane operator-(SseLane a, SseLane b) { return { _mm_sub_ps(a.v, b.v) }; }
+	inline SseLane operator*(SseLane a, SseLane b) { return { _mm_mul_ps(a.v, b.v) }; }
+#endif
+
+	template <typename L>
+	struct LaneVec3 {
+		L x, y, z;
+	};
+
+	template <typename L>
+	struct LaneQuat {
+		L w, x, y, z;
+	};
+
+	template <typename L>
+	LaneVec3<L> operator+(const LaneVec3<L>& a, const LaneVec3<L>& b) {
+		return { a.x + b.x, a.y + b.y, a.z + b.z };
+	}
+
+	template <typename L>
+	LaneVec3<L> operator*(const LaneVec3<L>& a, L s) {
+		return { a.x * s, a.y * s, a.z * s };
+	}
+
+	template <typename L>
+	LaneVec3<L> cross(const LaneVec3<L>& a, const LaneVec3<L>& b) {
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	// v rotated by unit quaternion q: v + w*t + q.xyz x t, with t = 2 * (q.xyz x v)
+	template <typename L>
+	LaneVec3<L> rotate(const LaneQuat<L>& q, const LaneVec3<L>& v) {
+		const LaneVec3<L> u = { q.x, q.y, q.z };
+		const LaneVec3<L> t = cross(u, v) * L::set(2.0f);
+		return v + t * q.w + cross(u, t);
+	}
+
+	template <typename L>
+	LaneQuat<L> operator*(const LaneQuat<L>& a, const LaneQuat<L>& b) {
+		return {
+			a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+			a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+			a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w
+		};
+	}
+
+	// Structure-of-arrays buffer of every tracker reported in a tick. The poses and physics data are
+	// queued as PSMoveService reports them and converted in one pass: the per-device offset is applied
+	// in the device's frame, the result scaled into meters and moved into the room by the alignment.
+	class PoseBatch {
+	public:
+		enum Field {
+			PX, PY, PZ, QW, QX, QY, QZ,	// Pose
+			VX, VY, VZ, AX, AY, AZ,	// Linear velocity and acceleration
+			WX, WY, WZ, BX, BY, BZ,	// Angular velocity and acceleration
+			OX, OY, OZ, OW, OI, OJ, OK,	// Per-device offset, position then orientation
+			FIELD_COUNT
+		};
+
+		// Sizes the buffer once, so queueing during update() never allocates
+		void reserve(size_t capacity) {
+			stride_ = (capacity + 3) & ~size_t(3);
+			data_.assign(stride_ * FIELD_COUNT, 0.0f);
+		}
+		void clear() {
+			size_ = 0;
+		}
+		size_t size() const {
+			return size_;
+		}
+		void add(const PSMPosef& pose, const PSMPhysicsData& physics, const RigidTransform& offset) {
+			const size_t i = size_++;
+			set(PX, i, pose.Position.x); set(PY, i, pose.Position.y); set(PZ, i, pose.Position.z);
+			set(QW, i, pose.Orientation.w); set(QX, i, pose.Orientation.x); set(QY, i, pose.Orientation.y); set(QZ, i, pose.Orientation.z);
+			set(VX, i, physics.LinearVelocityCmPerSec.x); set(VY, i, physics.LinearVelocityCmPerSec.y); set(VZ, i, physics.LinearVelocityCmPerSec.z);
+			set(AX, i, physics.LinearAccelerationCmPerSecSqr.x); set(AY, i, physics.LinearAccelerationCmPerSecSqr.y); set(AZ, i, physics.LinearAccelerationCmPerSecSqr.z);
+			set(WX, i, physics.AngularVelocityRadPerSec.x); set(WY, i, physics.AngularVelocityRadPerSec.y); set(WZ, i, physics.AngularVelocityRadPerSec.z);
+			set(BX, i, physics.AngularAccelerationRadPerSecSqr.x); set(BY, i, physics.AngularAccelerationRadPerSecSqr.y); set(BZ, i, physics.AngularAccelerationRadPerSecSqr.z);
+			set(OX, i, offset.position[0]); set(OY, i, offset.position[1]); set(OZ, i, offset.position[2]);
+			set(OW, i, offset.orientation[0]); set(OI, i, offset.orientation[1]); set(OJ, i, offset.orientation[2]); set(OK, i, offset.orientation[3]);
+		}
+
+		// Converts every queued entry from PSMoveService units into the aligned OSVR room
+		void transform(float unit_scale, const RigidTransform& alignment) {
+			size_t i = 0;
+#if POSE_BATCH_SSE
+			i = transform_lanes<SseLane>(i, unit_scale, alignment);
+#endif
+			transform_lanes<ScalarLane>(i, unit_scale, alignment);
+		}
+
+		OSVR_PoseState pose(size_t i) const {
+			OSVR_PoseState pstate;
+			osvrVec3SetX(&(pstate.translation), get(PX, i));
+			osvrVec3SetY(&(pstate.translation), get(PY, i));
+			osvrVec3SetZ(&(pstate.translation), get(PZ, i));
+			osvrQuatSetW(&(pstate.rotation), get(QW, i));
+			osvrQuatSetX(&(pstate.rotation), get(QX, i));
+			osvrQuatSetY(&(pstate.rotation), get(QY, i));
+			osvrQuatSetZ(&(pstate.rotation), get(QZ, i));
+			return pstate;
+		}
+		OSVR_VelocityState velocity(size_t i) const {
+			OSVR_VelocityState vstate;
+			osvrVec3SetX(&(vstate.linearVelocity), get(VX, i));
+			osvrVec3SetY(&(vstate.linearVelocity), get(VY, i));
+			osvrVec3SetZ(&(vstate.linearVelocity), get(VZ, i));
+			vstate.linearVelocityValid = true;
+			vstate.angularVelocity = incremental_rotation(get(WX, i), get(WY, i), get(WZ, i), INCREMENTAL_ROTATION_DT);
+			vstate.angularVelocityValid = true;
+			return vstate;
+		}
+		OSVR_AccelerationState acceleration(size_t i) const {
+			OSVR_AccelerationState astate;
+			osvrVec3SetX(&(astate.linearAcceleration), get(AX, i));
+			osvrVec3SetY(&(astate.linearAcceleration), get(AY, i));
+			osvrVec3SetZ(&(astate.linearAcceleration), get(AZ, i));
+			astate.linearAccelerationValid = true;
+			astate.angularAcceleration = incremental_rotation(get(BX, i), get(BY, i), get(BZ, i), INCREMENTAL_ROTATION_DT);
+			astate.angularAccelerationValid = true;
+			return astate;
+		}
+
+		// Extrapolates converted entry i dt seconds ahead from its physics. Position uses constant
+		// acceleration, orientation integrates the (world space) angular velocity advanced by half the
+		// angular acceleration over the interval.
+		void predict(size_t i, double dt) {
+			for (int k = 0; k < 3; k++)
+				set(Field(PX + k), i, get(Field(PX + k), i) + (float)(get(Field(VX + k), i) * dt + 0.5 * get(Field(AX + k), i) * dt * dt));
+
+			const double rx = (get(WX, i) + 0.5 * get(BX, i) * dt) * dt;
+			const double ry = (get(WY, i) + 0.5 * get(BY, i) * dt) * dt;
+			const double rz = (get(WZ, i) + 0.5 * get(BZ, i) * dt) * dt;
+			const double angle = std::sqrt(rx * rx + ry * ry + rz * rz);
+			if (angle < 1e-9)
+				return;
+
+			// Rotation of angle radians about (rx, ry, rz), applied in world space: q' = dq * q
+			const double s = std::sin(angle / 2) / angle;
+			const double dw = std::cos(angle / 2), dx = rx * s, dy = ry * s, dz = rz * s;
+			const double w = get(QW, i), x = get(QX, i), y = get(QY, i), z = get(QZ, i);
+			const double qw = dw * w - dx * x - dy * y - dz * z;
+			const double qx = dw * x + dx * w + dy * z - dz * y;
+			const double qy = dw * y - dx * z + dy * w + dz * x;
+			const double qz = dw * z + dx * y - dy * x + dz * w;
+			const double norm = std::sqrt(qw * qw + qx * qx + qy * qy + qz * qz);
+			set(QW, i, (float)(qw / norm)); set(QX, i, (float)(qx / norm)); set(QY, i, (float)(qy / norm)); set(QZ, i, (float)(qz / norm));
+		}
+
+		// Element access for stages that run on the converted batch
+		void set(Field f, size_t i, float value) {
+			data_[f * stride_ + i] = value;
+		}
+		float get(Field f, size_t i) const {
+			return data_[f * stride_ + i];
+		}
+
+	private:
+		float* field(Field f) {
+			return data_.data() + f * stride_;
+		}
+
+		// Processes entries from begin in whole lanes of L::WIDTH, returns where it stopped
+		template <typename L>
+		size_t transform_lanes(size_t begin, float unit_scale, const RigidTransform& alignment) {
+			const L scale = L::set(unit_scale);
+			const LaneVec3<L> align_p = { L::set(alignment.position[0]), L::set(alignment.position[1]), L::set(alignment.position[2]) };
+			const LaneQuat<L> align_q = { L::set(alignment.orientation[0]), L::set(alignment.orientation[1]), L::set(alignment.orientation[2]), L::set(alignment.orientation[3]) };
+
+			size_t i = begin;
+			for (; i + L::WIDTH <= size_; i += L::WIDTH) {
+				auto load3 = [this, i](Field x, Field y, Field z) {
+					return LaneVec3<L>{ L::load(field(x) + i), L::load(field(y) + i), L::load(field(z) + i) };
+				};
+				auto store3 = [this, i](const LaneVec3<L>& v, Field x, Field y, Field z) {
+					v.x.store(field(x) + i); v.y.store(field(y) + i); v.z.store(field(z) + i);
+				};
+				const LaneQuat<L> q = { L::load(field(QW) + i), L::load(field(QX) + i), L::load(field(QY) + i), L::load(field(QZ) + i) };
+				const LaneQuat<L> offset_q = { L::load(field(OW) + i), L::load(field(OI) + i), L::load(field(OJ) + i), L::load(field(OK) + i) };
+				const LaneVec3<L> w = load3(WX, WY, WZ);
+				const LaneVec3<L> b = load3(BX, BY, BZ);
+
+				// Lever arm of the offset in the room, it also adds to the velocity and acceleration
+				const LaneVec3<L> r = rotate(q, load3(OX, OY, OZ));
+				const LaneVec3<L> p = load3(PX, PY, PZ) * scale + r;
+				const LaneVec3<L> v = load3(VX, VY, VZ) * scale + cross(w, r);
+				const LaneVec3<L> a = load3(AX, AY, AZ) * scale + cross(b, r) + cross(w, cross(w, r));
+
+				store3(rotate(align_q, p) + align_p, PX, PY, PZ);
+				store3(rotate(align_q, v), VX, VY, VZ);
+				store3(rotate(align_q, a), AX, AY, AZ);
+				store3(rotate(align_q, w), WX, WY, WZ);
+				store3(rotate(align_q, b), BX, BY, BZ);
+
+				const LaneQuat<L> out_q = align_q * q * offset_q;
+				out_q.w.store(field(QW) + i); out_q.x.store(field(QX) + i); out_q.y.store(field(QY) + i); out_q.z.store(field(QZ) + i);
+			}
+			return i;
+		}
+
+		// OSVR expresses angular rates as the rotation accumulated over a short interval
+		static OSVR_IncrementalQuaternion incremental_rotation(double x, double y, double z, double dt) {
+			OSVR_IncrementalQuaternion incremental;
+			incremental.dt = dt;
+			osvrQuatSetIdentity(&(incremental.incrementalRotation));
+			const double rx = x * dt, ry = y * dt, rz = z * dt;
+			const double angle = std::sqrt(rx * rx + ry * ry + rz * rz);
+			if (angle < 1e-9)
+				return incremental;
+			const double s = std::sin(angle / 2) / angle;
+			osvrQuatSetW(&(incremental.incrementalRotation), std::cos(angle / 2));
+			osvrQuatSetX(&(incremental.incrementalRotation), rx * s);
+			osvrQuatSetY(&(incremental.incrementalRotation), ry * s);
+			osvrQuatSetZ(&(incremental.incrementalRotation), rz * s);
+			return incremental;
+		}
+
+		std::vector<float> data_;
+		size_t stride_ = 0;
+		size_t size_ = 0;
+	};
+
+	// Reads {"position": [x, y, z], "orientation": [w, x, y, z]}, either part optional
+	bool parse_transform(const Json::Value& config, RigidTransform& transform) {
+		const Json::Value& position = config["position"];
+		const Json::Value& orientation = config["orientation"];
+		if ((!position.isNull() && position.size() != 3) || (!orientation.isNull() && orientation.size() != 4))
+			return false;
+		for (Json::ArrayIndex i = 0; i < position.size(); i++)
+			transform.position[i] = position[i].asFloat();
+		if (orientation.isNull())
+			return true;
+		float norm = 0;
+		for (Json::ArrayIndex i = 0; i < 4; i++) {
+			transform.orientation[i] = orientation[i].asFloat();
+			norm += transform.orientation[i] * transform.orientation[i];
+		}
+		if (norm <= 0)
+			return false;
+		for (float& component : transform.orientation)
+			component /= std::sqrt(norm);
+		return true;
+	}
+
+	// A tracker report queued in a PoseBatch, stamped with the time PSMoveService sampled the frame
+	struct TrackerReport {
+		OSVR_ChannelCount sensor;
+		OSVR_TimeValue captured;
+		bool physics;
+		double prediction;	// Seconds to extrapolate the filtered pose ahead, 0 for none
+		OSVR_TimeValue stamp;	// The time the sent pose is for, captured plus the prediction
+	};
+
+	// Reads a device's "filter" config entry, returns false on an unknown type or a non-positive cutoff
+	bool parse_filter(const Json::Value& config, FilterSettings& filter) {
+		const std::string type = config.get("type", "none").asString();
+		if (type == "one_euro")
+			filter.type = FilterType::OneEuro;
+		else if (type == "adaptive")
+			filter.type = FilterType::Adaptive;
+		else if (type == "none")
+			filter.type = FilterType::None;
+		else
+			return false;
+		filter.min_cutoff_hz = config.get("min_cutoff_hz", filter.min_cutoff_hz).asDouble();
+		filter.beta = config.get("beta", filter.beta).asDouble();
+		filter.d_cutoff_hz = config.get("d_cutoff_hz", filter.d_cutoff_hz).asDouble();
+		filter.max_cutoff_hz = config.get("max_cutoff_hz", filter.max_cutoff_hz).asDouble();
+		filter.full_speed = config.get("full_speed", filter.full_speed).asDouble();
+		return filter.min_cutoff_hz > 0 && filter.d_cutoff_hz > 0 && filter.max_cutoff_hz >= filter.min_cutoff_hz && filter.full_speed > 0;
+	}
+
+	// Reads an "idle" config entry, returns false on a negative threshold or a keep-alive rate of 0
+	bool parse_idle(const Json::Value& config, IdleSettings& idle) {
+		idle.enabled = config.get("enabled", true).asBool();
+		idle.position_m = config.get("position_m", idle.position_m).asDouble();
+		idle.rotation_deg = config.get("rotation_deg", idle.rotation_deg).asDouble();
+		idle.after_ms = config.get("after_ms", idle.after_ms).asDouble();
+		idle.keepalive_hz = config.get("keepalive_hz", idle.keepalive_hz).asDouble();
+		return idle.position_m >= 0 && idle.rotation_deg >= 0 && idle.after_ms >= 0 && idle.keepalive_hz > 0;
+	}
+
+	// Smooths the converted poses of a PoseBatch, keeping each tracker's filter state between ticks
+	// in one structure-of-arrays buffer indexed by tracker channel.
+	class PoseFilterBank {
+	public:
+		void configure(OSVR_ChannelCount slot, const FilterSettings& settings) {
+			if (slot >= settings_.size()) {
+				settings_.resize(slot + 1);
+				time_.resize(slot + 1, 0.0);
+				valid_.resize(slot + 1, false);
+				state_.resize((slot + 1) * STATE_COUNT, 0.0f);
+			}
+			settings_[slot] = settings;
+		}
+
+		// Filters every queued pose in place, entries line up with reports
+		void apply(PoseBatch& batch, const std::vector<TrackerReport>& reports) {
+			for (size_t i = 0; i < reports.size(); i++) {
+				const OSVR_ChannelCount slot = reports[i].sensor;
+				if (slot >= settings_.size() || settings_[slot].type == FilterType::None)
+					continue;
+				const FilterSettings& settings = settings_[slot];
+				float* state = state_.data() + slot * STATE_COUNT;
+				const double time = time_value_seconds(reports[i].captured);
+				const double dt = time - time_[slot];
+				time_[slot] = time;
+
+				float p[3] = { batch.get(PoseBatch::PX, i), batch.get(PoseBatch::PY, i), batch.get(PoseBatch::PZ, i) };
+				float q[4] = { batch.get(PoseBatch::QW, i), batch.get(PoseBatch::QX, i), batch.get(PoseBatch::QY, i), batch.get(PoseBatch::QZ, i) };
+
+				// Nothing to smooth against on the first frame or after a gap, e.g. the device reconnecting
+				if (!valid_[slot] || dt <= 0 || dt > FILTER_RESET_SECONDS) {
+					std::copy(p, p + 3, state + X);
+					std::copy(q, q + 4, state + QW);
+					std::fill(state + DX, state + DX + 3, 0.0f);
+					state[DQ] = 0;
+					valid_[slot] = true;
+					continue;
+				}
+
+				// Speed estimates, themselves smoothed so jitter doesn't open the filter up
+				const float alpha_d = smoothing(settings.d_cutoff_hz, dt);
+				float speed = 0;
+				for (int k = 0; k < 3; k++) {
+					state[DX + k] += alpha_d * ((p[k] - state[X + k]) / (float)dt - state[DX + k]);
+					speed += state[DX + k] * state[DX + k];
+				}
+				speed = std::sqrt(speed);
+
+				float dot = state[QW] * q[0] + state[QX] * q[1] + state[QY] * q[2] + state[QZ] * q[3];
+				if (dot < 0) {
+					// q and -q are the same rotation, take the short way round
+					for (float& component : q)
+						component = -component;
+					dot = -dot;
+				}
+				const float angular_rate = 2.0f * std::acos(std::min(dot, 1.0f)) / (float)dt;
+				state[DQ] += alpha_d * (angular_rate - state[DQ]);
+				float angular_speed = state[DQ];
+
+				// The adaptive filter prefers PSMoveService's own velocity estimate, which doesn't lag
+				if (settings.type == FilterType::Adaptive && reports[i].physics) {
+					speed = length(batch.get(PoseBatch::VX, i), batch.get(PoseBatch::VY, i), batch.get(PoseBatch::VZ, i));
+					angular_speed = length(batch.get(PoseBatch::WX, i), batch.get(PoseBatch::WY, i), batch.get(PoseBatch::WZ, i));
+				}
+
+				const float alpha_p = smoothing(cutoff(settings, speed), dt);
+				for (int k = 0; k < 3; k++)
+					state[X + k] += alpha_p * (p[k] - state[X + k]);
+
+				// Normalized lerp, close enough to a slerp for the small steps between frames
+				const float alpha_q = smoothing(cutoff(settings, angular_speed), dt);
+				float norm = 0;
+				for (int k = 0; k < 4; k++) {
+					state[QW + k] += alpha_q * (q[k] - state[QW + k]);
+					norm += state[QW + k] * state[QW + k];
+				}
+				norm = std::sqrt(norm);
+				for (int k = 0; k < 4; k++)
+					state[QW + k] /= norm;
+
+				batch.set(PoseBatch::PX, i, state[X]); batch.set(PoseBatch::PY, i, state[Y]); batch.set(PoseBatch::PZ, i, state[Z]);
+				batch.set(PoseBatch::QW, i, state[QW]); batch.set(PoseBatch::QX, i, state[QX]); batch.set(PoseBatch::QY, i, state[QY]); batch.set(PoseBatch::QZ, i, state[QZ]);
+			}
+		}
+
+	private:
+		enum State {
+			X, Y, Z, DX, DY, DZ,	// Filtered position and its smoothed derivative
+			QW, QX, QY, QZ, DQ,	// Filtered orientation and its smoothed angular speed
+			STATE_COUNT
+		};
+
+		// Longer than this between frames and the filter starts over
+		static constexpr double FILTER_RESET_SECONDS = 0.25;
+
+		// Weight of a new sample for a first order low-pass at cutoff_hz
+		static float smoothing(double cutoff_hz, double dt) {
+			const double tau = 1.0 / (2.0 * 3.14159265358979 * cutoff_hz);
+			return (float)(1.0 / (1.0 + tau / dt));
+		}
+
+		static float cutoff(const FilterSettings& settings, float speed) {
+			if (settings.type == FilterType::OneEuro)
+				return (float)(settings.min_cutoff_hz + settings.beta * speed);
+			const double t = std::min(speed / settings.full_speed, 1.0);
+			return (float)(settings.min_cutoff_hz + (settings.max_cutoff_hz - settings.min_cutoff_hz) * t);
+		}
+
+		static float length(float x, float y, float z) {
+			return std::sqrt(x * x + y * y + z * z);
+		}
+
+		std::vector<FilterSettings> settings_;
+		std::vector<double> time_;
+		std::vector<bool> valid_;
+		std::vector<float> state_;
+	};
+
+	// Holds back the tracker reports of devices lying still, down to a keep-alive rate. Each new pose
+	// is compared with the one where the device last moved, so slow drift still wakes it eventually,
+	// and any button or analog change wakes it at once. Indexed by the device's position in its group.
+	class ActivityGate {
+	public:
+		void configure(size_t slot, const IdleSettings& settings) {
+			if (slot >= slots_.size())
+				slots_.resize(slot + 1);
+			Slot& state = slots_[slot];
+			state.enabled = settings.enabled;
+			state.position_m = settings.position_m;
+			state.min_dot = std::cos(settings.rotation_deg * 3.14159265358979 / 360.0);
+			state.after = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::milli>(settings.after_ms));
+			state.keepalive = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / settings.keepalive_hz));
+		}
+
+		// Forgets where the device was, so it reports as soon as it comes back
+		void reset(size_t slot) {
+			slots_[slot].seen = false;
+		}
+
+		// Whether a new pose should be reported this tick
+		bool admit(size_t slot, const PSMPosef& pose, bool inputs_changed, clock::time_point now) {
+			Slot& state = slots_[slot];
+			if (!state.enabled)
+				return true;
+			if (!state.seen || inputs_changed || moved(state, pose)) {
+				state.seen = true;
+				state.anchor = pose;
+				state.active_until = now + state.after;
+			}
+			if (now >= state.active_until && now < state.next_keepalive)
+				return false;
+			state.next_keepalive = now + state.keepalive;
+			return true;
+		}
+
+	private:
+		struct Slot {
+			bool enabled = false;
+			float position_m = 0;
+			double min_dot = 1;	// Cosine of half the wake rotation
+			clock::duration after = clock::duration::zero();
+			clock::duration keepalive = clock::duration::zero();
+			bool seen = false;
+			PSMPosef anchor = {};
+			clock::time_point active_until;
+			clock::time_point next_keepalive;
+		};
+
+		static bool moved(const Slot& state, const PSMPosef& pose) {
+			const float dx = pose.Position.x - state.anchor.Position.x;
+			const float dy = pose.Position.y - state.anchor.Position.y;
+			const float dz = pose.Position.z - state.anchor.Position.z;
+			if (std::sqrt(dx * dx + dy * dy + dz * dz) * unit_scale > state.position_m)
+				return true;
+			const PSMQuatf& a = pose.Orientation;
+			const PSMQuatf& b = state.anchor.Orientation;
+			return std::abs(a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z) < state.min_dot;
+		}
+
+		std::vector<Slot> slots_;
+	};
+
+	// Log messages are copied into fixed slots of a ring and handed to OSVR by a background thread while
+	// the plugin is running, so the update callback and the poll thread never allocate or wait on OSVR to
+	// log. Before the thread starts and after it stops, messages go straight to OSVR. Either way, a
+	// message repeated within LOG_REPEAT_WINDOW is only counted, and the count is added to its next showing.
+	class LogRing {
+	public:
+		static const size_t SLOT_SIZE = 1024;
+		static const size_t SLOTS = 64;
+
+		~LogRing() {
+			stop();
+		}
+
+		void start() {
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (running_)
+				return;
+			running_ = true;
+			thread_ = std::thread(&LogRing::run, this);
+		}
+		// Hands over whatever is still queued, then goes back to logging directly
+		void stop() {
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (!running_)
+					return;
+				running_ = false;
+			}
+			cv_.notify_one();
+			thread_.join();
+		}
+
+		void submit(OSVR_PluginRegContext ctx, OSVR_LogLevel level, const char* text, size_t length) {
+			std::unique_lock<std::mutex> lock(mutex_);
+			unsigned int repeats = 0;
+			if (!admit(text, length, repeats))
+				return;
+			// Long messages take several slots, in order
+			if (!running_) {
+				lock.unlock();
+				Slot slot;
+				while (length > 0) {
+					const size_t chunk = chunk_length(text, length);
+					fill(slot, ctx, level, text, chunk, chunk == length ? repeats : 0);
+					osvr::pluginkit::log(slot.ctx, slot.level, slot.text);
+					text += chunk;
+					length -= chunk;
+				}
+				return;
+			}
+			while (length > 0) {
+				if (count_ == SLOTS) {
+					dropped_++;
+					break;
+				}
+				const size_t chunk = chunk_length(text, length);
+				fill(slots_[(head_ + count_) % SLOTS], ctx, level, text, chunk, chunk == length ? repeats : 0);
+				count_++;
+				text += chunk;
+				length -= chunk;
+			}
+			lock.unlock();
+			cv_.notify_one();
+		}
+
+	private:
+		struct Slot {
+			OSVR_PluginRegContext ctx;
+			OSVR_LogLevel level;
+			char text[SLOT_SIZE];
+		};
+		struct Recent {
+			uint64_t hash = 0;
+			clock::time_point logged;
+			unsigned int suppressed = 0;
+		};
+
+		// Room kept free in a slot for the repeat count
+		static const size_t SUFFIX_SIZE = 48;
+		static constexpr std::chrono::seconds LOG_REPEAT_WINDOW{ 5 };
+
+		// How much of the text fits in one slot, up to its last line break if it has to be split
+		static size_t chunk_length(const char* text, size_t length) {
+			const size_t limit = SLOT_SIZE - SUFFIX_SIZE;
+			if (length <= limit)
+				return length;
+			for (size_t i = limit; i > 0; i--) {
+				if (text[i - 1] == '\n')
+					return i;
+			}
+			return limit;
+		}
+
+		static void fill(Slot& slot, OSVR_PluginRegContext ctx, OSVR_LogLevel level, const char* text, size_t length, unsigned int repeats) {
+			slot.ctx = ctx;
+			slot.level = level;
+			length = std::min(length, SLOT_SIZE - SUFFIX_SIZE);
+			std::memcpy(slot.text, text, length);
+			slot.text[length] = '\0';
+			if (repeats > 0)
+				std::snprintf(slot.text + length, SUFFIX_SIZE, " (repeated %u more times)", repeats);
+		}
+
+		// Returns false if the same message went out less than LOG_REPEAT_WINDOW ago. Otherwise sets
+		// repeats to how many times it was held back since it last went out.
+		bool admit(const char* text, size_t length, unsigned int& repeats) {
+			uint64_t hash = 14695981039346656037ULL;
+			for (size_t i = 0; i < length; i++)
+				hash = (hash ^ (unsigned char)text[i]) * 1099511628211ULL;
+			const clock::time_point now = clock::now();
+			Recent* oldest = &recent_[0];
+			for (Recent& recent : recent_) {
+				if (recent.hash == hash) {
+					if (now - recent.logged < LOG_REPEAT_WINDOW) {
+						recent.suppressed++;
+						return false;
+					}
+					repeats = recent.suppressed;
+					recent.suppressed = 0;
+					recent.logged = now;
+					return true;
+				}
+				if (recent.logged < oldest->logged)
+					oldest = &recent;
+			}
+			oldest->hash = hash;
+			oldest->logged = now;
+			oldest->suppressed = 0;
+			return true;
+		}
+
+		void run() {
+			std::unique_lock<std::mutex> lock(mutex_);
+			for (;;) {
+				cv_.wait(lock, [this] { return count_ > 0 || !running_; });
+				if (count_ == 0)
+					break;
+				// Producers only write past the queued slots, so the head slot can be logged unlocked
+				if (dropped_ > 0) {
+					Slot& notice = slots_[head_];
+					const unsigned int dropped = dropped_;
+					dropped_ = 0;
+					lock.unlock();
+					char text[96];
+					std::snprintf(text, sizeof(text), "%u log messages were dropped because the log queue was full.", dropped);
+					osvr::pluginkit::log(notice.ctx, OSVR_LOGLEVEL_WARN, text);
+					lock.lock();
+				}
+				Slot& slot = slots_[head_];
+				lock.unlock();
+				osvr::pluginkit::log(slot.ctx, slot.level, slot.text);
+				lock.lock();
+				head_ = (head_ + 1) % SLOTS;
+				count_--;
+			}
+		}
+
+		std::mutex mutex_;
+		std::condition_variable cv_;
+		bool running_ = false;
+		std::array<Slot, SLOTS> slots_;
+		size_t head_ = 0;
+		size_t count_ = 0;
+		unsigned int dropped_ = 0;
+		std::array<Recent, 32> recent_;
+		std::thread thread_;
+	};
+	LogRing log_ring;
+
+	// Formats into a fixed buffer, text past the end is cut off
+	class FixedStreamBuffer : public std::streambuf {
+	public:
+		FixedStreamBuffer(char* buffer, size_t size) {
+			setp(buffer, buffer + size);
+		}
+		const char* data() const {
+			return pbase();
+		}
+		size_t size() const {
+			return pptr() - pbase();
+		}
+		void reset() {
+			setp(pbase(), epptr());
+		}
+	};
+
 	class Logger {
 	public:
-		Logger(OSVR_PluginRegContext& ctx):ctx_(ctx){};
+		Logger(OSVR_PluginRegContext& ctx):ctx_(ctx), buffer_(text_, sizeof(text_)), log_stream_(&buffer_){};
 		~Logger() {};
 		std::ostream& get() {
 			return log_stream_;
@@ -48,9 +2066,10 @@ namespace
 			OSVR_LogLevel level = OSVR_LOGLEVEL_INFO;
 			if (warning_)
 				level = OSVR_LOGLEVEL_WARN;
-			osvr::pluginkit::log(ctx_, level, log_stream_.str().c_str());
+			log_ring.submit(ctx_, level, buffer_.data(), buffer_.size());
 			if (flush) {
-				log_stream_.str("");
+				buffer_.reset();
+				log_stream_.clear();
 				warning_ = false;
 			}
 		}
@@ -59,14 +2078,578 @@ namespace
 		}
 		private:
 			OSVR_PluginRegContext& ctx_;
-			std::stringstream log_stream_;
+			// Big enough for the JSON descriptor with plenty of devices
+			char text_[16 * LogRing::SLOT_SIZE];
+			FixedStreamBuffer buffer_;
+			std::ostream log_stream_;
 			bool warning_ = false;
 	};
 
+	// Runs the log ring's thread for as long as it is alive
+	class LogThread {
+	public:
+		LogThread() {
+			log_ring.start();
+		}
+		~LogThread() {
+			log_ring.stop();
+		}
+	};
+
+	// Detaches a device whose stream didn't start, so the poll thread's next device list check attaches it again
+	void detach_failed_stream(Logger& log, DeviceRecord& device, PSMResult result) {
+		device.feed->detach();
+		log.get() << "Failed to start the data stream for \"" << device.name << "\" with error: [" << result << "] " << psm_error_str(result)
+			<< ", retrying on the next device list check.";
+		log.set_warning(true);
+		log.send();
+	}
+
+	// Summarizes the metrics gathered since the last report, to the log when debug is on and as a JSON line
+	// appended to the metrics file if there is one. Every group's update callback offers to take the
+	// snapshot, the first one past the interval does. The poll thread then turns it into the report, so
+	// the update callbacks never build JSON or wait on the file.
+	class MetricsReporter {
+	public:
+		MetricsReporter(OSVR_PluginRegContext ctx):ctx_(ctx), previous_devices_(devices.size()), previous_groups_(groups.size()),
+			interval_devices_(devices.size()), interval_groups_(groups.size()) {
+			if (metrics_file.empty())
+				return;
+			file_.open(metrics_file, std::ios::app);
+			if (!file_) {
+				Logger log(ctx_);
+				log.get() << "Could not open metrics file \"" << metrics_file << "\", metrics will only be logged.";
+				log.set_warning(true);
+				log.send();
+			}
+		}
+
+		// Update thread: takes the snapshot once the interval has passed. Until the poll thread has
+		// written it, no new one is taken and the next report covers the longer interval.
+		void report(clock::time_point now) {
+			std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+			if (!lock.owns_lock() || ready_ || now < next_report_)
+				return;
+			interval_seconds_ = std::chrono::duration<double>(now - last_report_).count();
+			next_report_ = now + metrics_interval;
+			last_report_ = now;
+			osvrTimeValueGetNow(&interval_time_);
+
+			interval_polls_ = delta(poll_metrics.polls, previous_polls_);
+			interval_psm_update_ = delta(poll_metrics.psm_update, previous_psm_update_);
+			for (size_t i = 0; i < groups.size(); i++) {
+				const ReportMetrics& metrics = groups[i]->metrics;
+				GroupCounts& previous = previous_groups_[i];
+				GroupCounts& interval = interval_groups_[i];
+				interval.ticks = delta(metrics.ticks, previous.ticks);
+				interval.calls = delta(metrics.calls, previous.calls);
+				interval.interval = delta(metrics.interval, previous.interval);
+				interval.tick_cost = delta(metrics.tick_cost, previous.tick_cost);
+				interval.convert = delta(metrics.convert, previous.convert);
+				interval.send = delta(metrics.send, previous.send);
+			}
+			for (size_t i = 0; i < devices.size(); i++) {
+				const DeviceMetrics& metrics = devices[i].feed->metrics;
+				DeviceCounts& previous = previous_devices_[i];
+				DeviceCounts& interval = interval_devices_[i];
+				interval.frames = delta(metrics.frames, previous.frames);
+				interval.dropped = delta(metrics.dropped, previous.dropped);
+				interval.repeats = delta(metrics.repeats, previous.repeats);
+				interval.idle = delta(metrics.idle, previous.idle);
+				interval.imu_samples = delta(metrics.imu_samples, previous.imu_samples);
+				interval.imu_lost = delta(metrics.imu_lost, previous.imu_lost);
+				interval.latency = delta(metrics.latency, previous.latency);
+				interval.age = delta(metrics.age, previous.age);
+			}
+			ready_ = true;
+		}
+
+		// Poll thread: logs and writes the snapshot, if one was taken. The update threads leave it alone
+		// until it is handed back.
+		void write() {
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (!ready_)
+					return;
+			}
+
+			Json::Value report;
+			report["time"] = time_value_seconds(interval_time_);
+			report["seconds"] = interval_seconds_;
+			report["polls"] = (Json::UInt64)interval_polls_;
+			report["psm_update_us"] = interval_psm_update_.to_json();
+			for (size_t i = 0; i < groups.size(); i++) {
+				if (groups[i]->devices.empty())
+					continue;
+				const GroupCounts& interval = interval_groups_[i];
+				Json::Value group;
+				group["ticks"] = (Json::UInt64)interval.ticks;
+				group["calls"] = (Json::UInt64)interval.calls;
+				group["interval_us"] = interval.interval.to_json();
+				group["tick_cost_us"] = interval.tick_cost.to_json();
+				group["convert_us"] = interval.convert.to_json();
+				group["send_us"] = interval.send.to_json();
+				report["groups"][groups[i]->name] = group;
+			}
+			for (size_t i = 0; i < devices.size(); i++) {
+				const DeviceCounts& interval = interval_devices_[i];
+				Json::Value device;
+				device["frames"] = (Json::UInt64)interval.frames;
+				device["dropped"] = (Json::UInt64)interval.dropped;
+				device["repeats"] = (Json::UInt64)interval.repeats;
+				if (devices[i].feed->settings.idle.enabled)
+					device["idle"] = (Json::UInt64)interval.idle;
+				if (devices[i].imu) {
+					device["imu_samples"] = (Json::UInt64)interval.imu_samples;
+					device["imu_lost"] = (Json::UInt64)interval.imu_lost;
+				}
+				device["latency_us"] = interval.latency.to_json();
+				device["age_us"] = interval.age.to_json();
+				report["devices"][devices[i].name] = device;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				ready_ = false;
+			}
+			if (display_json)
+				log_report(report);
+			if (file_.is_open()) {
+				Json::FastWriter writer;
+				file_ << writer.write(report);
+				file_.flush();
+			}
+		}
+
+	private:
+		struct DeviceCounts {
+			uint64_t frames = 0;
+			uint64_t dropped = 0;
+			uint64_t repeats = 0;
+			uint64_t idle = 0;
+			uint64_t imu_samples = 0;
+			uint64_t imu_lost = 0;
+			Histogram::Snapshot latency;
+			Histogram::Snapshot age;
+		};
+		struct GroupCounts {
+			uint64_t ticks = 0;
+			uint64_t calls = 0;
+			Histogram::Snapshot interval;
+			Histogram::Snapshot tick_cost;
+			Histogram::Snapshot convert;
+			Histogram::Snapshot send;
+		};
+
+		static uint64_t delta(const Counter& counter, uint64_t& previous) {
+			const uint64_t value = counter.value();
+			const uint64_t change = value - previous;
+			previous = value;
+			return change;
+		}
+		static Histogram::Snapshot delta(const Histogram& histogram, Histogram::Snapshot& previous) {
+			Histogram::Snapshot snapshot = histogram.snapshot();
+			Histogram::Snapshot change = snapshot - previous;
+			previous = snapshot;
+			return change;
+		}
+		static void write_histogram(std::ostream& out, const Json::Value& summary) {
+			out << "p50 " << summary["p50"].asUInt64() << "us, p99 " << summary["p99"].asUInt64() << "us, max " << summary["max"].asUInt64() << "us";
+		}
+
+		void log_report(const Json::Value& report) {
+			Logger log(ctx_);
+			std::ostream& out = log.get();
+			out << "Metrics for the last " << report["seconds"].asDouble() << "s:";
+			for (const std::string& name : report["groups"].getMemberNames()) {
+				const Json::Value& group = report["groups"][name];
+				const double ticks = std::max(group["ticks"].asDouble(), 1.0);
+				out << std::endl << "  Reporting " << name << ": " << group["ticks"].asUInt64() << " ticks, " << group["calls"].asDouble() / ticks << " OSVR calls per tick";
+				out << std::endl << "    interval "; write_histogram(out, group["interval_us"]);
+				out << std::endl << "    tick cost "; write_histogram(out, group["tick_cost_us"]);
+				out << std::endl << "    convert "; write_histogram(out, group["convert_us"]);
+				out << std::endl << "    send "; write_histogram(out, group["send_us"]);
+			}
+			out << std::endl << "  Polling: " << report["polls"].asUInt64() << " polls, PSM_UpdateNoPollMessages "; write_histogram(out, report["psm_update_us"]);
+			for (const DeviceRecord& device : devices) {
+				const Json::Value& metrics = report["devices"][device.name];
+				out << std::endl << "  " << device.name << ": " << metrics["frames"].asUInt64() << " frames, "
+					<< metrics["dropped"].asUInt64() << " dropped, " << metrics["repeats"].asUInt64() << " repeats";
+				if (device.feed->settings.idle.enabled)
+					out << ", " << metrics["idle"].asUInt64() << " held back while idle";
+				if (device.imu)
+					out << ", " << metrics["imu_samples"].asUInt64() << " IMU samples, " << metrics["imu_lost"].asUInt64() << " lost";
+				if (device.type->tracked) {
+					out << std::endl << "    latency "; write_histogram(out, metrics["latency_us"]);
+					out << std::endl << "    frame age "; write_histogram(out, metrics["age_us"]);
+				}
+			}
+			log.send();
+		}
+
+		OSVR_PluginRegContext ctx_;
+		std::ofstream file_;
+		clock::time_point last_report_ = clock::now();
+		clock::time_point next_report_ = clock::now() + metrics_interval;
+		std::mutex mutex_;	// Guards ready_ and the report timing, the update threads only try it
+		bool ready_ = false;	// A snapshot is waiting for the poll thread
+
+		// Totals at the last snapshot, and the changes since the one before, which make up the report
+		uint64_t previous_polls_ = 0;
+		Histogram::Snapshot previous_psm_update_;
+		std::vector<DeviceCounts> previous_devices_;
+		std::vector<GroupCounts> previous_groups_;
+		OSVR_TimeValue interval_time_ = {};
+		double interval_seconds_ = 0.0;
+		uint64_t interval_polls_ = 0;
+		Histogram::Snapshot interval_psm_update_;
+		std::vector<DeviceCounts> interval_devices_;
+		std::vector<GroupCounts> interval_groups_;
+	};
+
+	// Owns the PSMoveService client once the driver is running. Polls it on a dedicated thread and
+	// publishes every device's state through its DeviceFeed, so a stall on the network side never
+	// holds up the OSVR device thread. It also attaches configured devices as they connect and
+	// detaches them when they disappear, so none of that happens on the OSVR device thread either.
+	class PsmPoller {
+	public:
+		PsmPoller(OSVR_PluginRegContext ctx, MetricsReporter& reporter):ctx_(ctx), reporter_(reporter), signals_(new GroupSignal[groups.size()]), published_(groups.size(), false), starts_(devices.size()), wrong_type_(devices.size(), false) {
+			thread_ = std::thread(&PsmPoller::run, this);
+		}
+		~PsmPoller() {
+			running_ = false;
+			thread_.join();
+			// A snapshot taken after the last poll still goes out
+			reporter_.write();
+		}
+		// Blocks until a device of the group publishes a frame newer than seen_generation or the deadline
+		// passes, returns true on a new frame. Each group's update thread keeps its own seen_generation.
+		bool wait_for_frame(size_t group, clock::time_point deadline, unsigned long long& seen_generation) {
+			GroupSignal& signal = signals_[group];
+			std::unique_lock<std::mutex> lock(mutex_);
+			bool fresh = signal.cv.wait_until(lock, deadline, [&signal, &seen_generation] { return signal.generation != seen_generation; });
+			seen_generation = signal.generation;
+			return fresh;
+		}
+	private:
+		void run() {
+			last_frame_ = clock::now();
+			while (running_) {
+				if (metrics_enabled)
+					reporter_.write();
+				if (frame_replayer) {
+					replay();
+					continue;
+				}
+				if (!connected_) {
+					reconnect();
+					continue;
+				}
+
+				clock::time_point poll_start = metrics_enabled ? clock::now() : clock::time_point();
+				PSMResult result = PSM_UpdateNoPollMessages();
+				if (metrics_enabled) {
+					poll_metrics.psm_update.record(clock::now() - poll_start);
+					poll_metrics.polls.add();
+				}
+				bool published = false;
+				bool any_attached = false;
+				for (size_t i = 0; i < devices.size(); i++) {
+					DeviceRecord& device = devices[i];
+					if (device.feed->pump()) {
+						published_[device.group] = true;
+						published = true;
+					}
+					// A device whose stream hasn't started yet can't be expected to deliver anything
+					any_attached |= device.feed->attached() && !starts_[i].pending;
+				}
+				clock::time_point now = clock::now();
+				check_stream_starts(now);
+				if (published || !any_attached)
+					last_frame_ = now;
+
+				// Watchdog: a dropped socket, or attached devices that have all gone silent, means PSMoveService is gone
+				if (result == PSMResult_Error || !PSM_GetIsConnected() || now - last_frame_ > watchdog_timeout) {
+					lose_connection(result == PSMResult_Error || !PSM_GetIsConnected() ? "connection lost" : "no data received");
+					std::fill(published_.begin(), published_.end(), true);
+					notify();
+					continue;
+				}
+
+				if (PSM_HasControllerListChanged() || PSM_HasHMDListChanged() || now >= next_rescan_)
+					request_device_lists();
+				if (controller_list_ready_ && hmd_list_ready_)
+					reconcile_devices();
+
+				notify();
+				std::this_thread::sleep_for(POLL_INTERVAL);
+			}
+		}
+
+		// Wakes the update callbacks in event mode of the groups that had a device publish or change,
+		// leaving the other groups asleep
+		void notify() {
+			bool any = false;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				for (size_t i = 0; i < published_.size(); i++) {
+					if (published_[i])
+						signals_[i].generation++;
+					any |= published_[i];
+				}
+			}
+			if (!any)
+				return;
+			for (size_t i = 0; i < published_.size(); i++) {
+				if (published_[i])
+					signals_[i].cv.notify_all();
+				published_[i] = false;
+			}
+		}
+
+		// Replay mode: the recording stands in for PSMoveService, devices come and go as they did when it was recorded
+		void replay() {
+			// As fast as possible still lets every device's last frame be reported before the next one
+			// replaces it, so no frame is skipped. Only yield while waiting, the update threads are quick.
+			if (!frame_replayer->realtime() && !std::all_of(devices.begin(), devices.end(), [](const DeviceRecord& device) { return device.feed->consumed(); })) {
+				std::this_thread::yield();
+				return;
+			}
+			frame_replayer->advance(clock::now());
+			frame_replayer->device_lists(controller_list_, hmd_list_);
+			reconcile_devices();
+			for (DeviceRecord& device : devices) {
+				if (device.feed->pump())
+					published_[device.group] = true;
+			}
+			notify();
+
+			if (frame_replayer->finished() && !replay_finished_) {
+				replay_finished_ = true;
+				Logger log(ctx_);
+				log.get() << "Replay finished, the devices keep their last recorded state.";
+				log.send();
+			}
+			// As fast as possible means one record per poll, without waiting in between
+			if (frame_replayer->realtime() || replay_finished_)
+				std::this_thread::sleep_for(POLL_INTERVAL);
+		}
+
+		// Detaches every device, so the update callback sees them all as disconnected, and drops the client
+		void lose_connection(const char* reason) {
+			for (DeviceRecord& device : devices) {
+				if (device.feed->attached())
+					device.feed->detach();
+			}
+			// Shutting down drops every callback still registered
+			for (StreamStart& start : starts_)
+				start.pending = false;
+			PSM_Shutdown();
+			connected_ = false;
+			controller_list_ready_ = hmd_list_ready_ = false;
+			lost_at_ = clock::now();
+			backoff_ = CONNECT_BACKOFF_MIN;
+
+			Logger log(ctx_);
+			log.get() << "Lost PSMoveService (" << reason << "), reconnecting in the background...";
+			log.set_warning(true);
+			log.send();
+		}
+
+		// One reconnection attempt, backing off exponentially after a failure. Once connected the
+		// regular device list check re-attaches and restarts the streams of all configured devices.
+		void reconnect() {
+			PSMResult result = PSM_Initialize(server_address.c_str(), server_port.c_str(), PSM_DEFAULT_TIMEOUT);
+			if (result == PSMResult_Success) {
+				connected_ = true;
+				last_frame_ = clock::now();
+				request_device_lists();
+
+				Logger log(ctx_);
+				log.get() << "Reconnected to PSMoveService after "
+					<< std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - lost_at_).count() << "ms.";
+				log.send();
+				return;
+			}
+
+			// Sleep in short steps so shutting down isn't held up by the backoff
+			const clock::time_point retry_at = clock::now() + backoff_;
+			while (running_ && clock::now() < retry_at)
+				std::this_thread::sleep_for(POLL_INTERVAL);
+			backoff_ = std::min(backoff_ * 2, CONNECT_BACKOFF_MAX);
+		}
+
+		// Asks PSMoveService which devices are connected, the answers arrive through on_*_list()
+		void request_device_lists() {
+			next_rescan_ = clock::now() + HOTPLUG_RESCAN_INTERVAL;
+			PSMRequestID request;
+			if (PSM_GetControllerListAsync(&request) == PSMResult_RequestSent)
+				PSM_RegisterCallback(request, &PsmPoller::on_controller_list, this);
+			if (PSM_GetHmdListAsync(&request) == PSMResult_RequestSent)
+				PSM_RegisterCallback(request, &PsmPoller::on_hmd_list, this);
+		}
+		static void on_controller_list(const PSMResponseMessage* response, void* userdata) {
+			PsmPoller* poller = static_cast<PsmPoller*>(userdata);
+			if (response->result_code == PSMResult_Success)
+				poller->controller_list_ = response->payload.controller_list;
+			poller->controller_list_ready_ = true;
+		}
+		static void on_hmd_list(const PSMResponseMessage* response, void* userdata) {
+			PsmPoller* poller = static_cast<PsmPoller*>(userdata);
+			if (response->result_code == PSMResult_Success)
+				poller->hmd_list_ = response->payload.hmd_list;
+			poller->hmd_list_ready_ = true;
+		}
+
+		// Attaches configured devices that are now connected and detaches ones that are gone, marking
+		// their groups to be woken
+		void reconcile_devices() {
+			controller_list_ready_ = hmd_list_ready_ = false;
+			for (size_t i = 0; i < devices.size(); i++) {
+				DeviceRecord& device = devices[i];
+				bool listed = false;
+				bool connected = false;
+				if (device.type->hmd) {
+					for (int j = 0; j < hmd_list_.count; j++) {
+						listed |= hmd_list_.hmd_id[j] == device.id;
+						connected |= (hmd_list_.hmd_id[j] == device.id && hmd_list_.hmd_type[j] == device.type->psm_type);
+					}
+				}
+				else {
+					for (int j = 0; j < controller_list_.count; j++) {
+						listed |= controller_list_.controller_id[j] == device.id;
+						connected |= (controller_list_.controller_id[j] == device.id && controller_list_.controller_type[j] == device.type->psm_type);
+					}
+				}
+
+				// A device of another type under the configured id stays detached, say so once
+				const bool wrong_type = listed && !connected;
+				if (wrong_type && !wrong_type_[i]) {
+					Logger log(ctx_);
+					log.get() << (device.type->hmd ? "HMD" : "Controller") << " [id:" << device.id << "] \"" << device.name << "\" connected, but it is not a "
+						<< device.type->description << ", leaving it detached.";
+					log.set_warning(true);
+					log.send();
+				}
+				wrong_type_[i] = wrong_type;
+
+				if (connected == device.feed->attached())
+					continue;
+
+				Logger log(ctx_);
+				if (connected) {
+					PSMRequestID request;
+					const PSMResult result = device.feed->attach(&request);
+					log.get() << "Controller or HMD [id:" << device.id << "] \"" << device.name << "\" connected, attaching it.";
+					log.send();
+					if (result == PSMResult_RequestSent)
+						watch_stream_start(i, request);
+					else if (result != PSMResult_Success)
+						stream_start_failed(device, result);
+				}
+				else {
+					starts_[i].pending = false;
+					device.feed->detach();
+					log.get() << "Controller or HMD [id:" << device.id << "] \"" << device.name << "\" disconnected, detaching it.";
+					log.set_warning(true);
+					log.send();
+				}
+				published_[device.group] = true;
+			}
+		}
+
+		// Follows a stream start until PSMoveService answers it. The device stays attached meanwhile.
+		void watch_stream_start(size_t device, PSMRequestID request) {
+			StreamStart& start = starts_[device];
+			start.request = request;
+			start.result = PSMResult_RequestSent;
+			start.deadline = clock::now() + STREAM_START_TIMEOUT;
+			start.pending = true;
+			PSM_RegisterCallback(request, &PsmPoller::on_stream_start, &start.result);
+		}
+		static void on_stream_start(const PSMResponseMessage* response, void* userdata) {
+			*static_cast<PSMResult*>(userdata) = response->result_code;
+		}
+		void check_stream_starts(clock::time_point now) {
+			for (size_t i = 0; i < starts_.size(); i++) {
+				StreamStart& start = starts_[i];
+				if (!start.pending)
+					continue;
+				if (start.result == PSMResult_RequestSent) {
+					if (now < start.deadline)
+						continue;
+					PSM_CancelCallback(start.request);
+					start.result = PSMResult_Timeout;
+				}
+				start.pending = false;
+				if (start.result != PSMResult_Success)
+					stream_start_failed(devices[i], start.result);
+			}
+		}
+		void stream_start_failed(DeviceRecord& device, PSMResult result) {
+			Logger log(ctx_);
+			detach_failed_stream(log, device, result);
+			published_[device.group] = true;
+		}
+
+		// What the update thread of one group waits on
+		struct GroupSignal {
+			std::condition_variable cv;
+			unsigned long long generation = 0;
+		};
+
+		OSVR_PluginRegContext ctx_;
+		MetricsReporter& reporter_;
+		std::atomic<bool> running_{ true };
+		std::mutex mutex_;	// Guards every group's generation
+		std::unique_ptr<GroupSignal[]> signals_;
+		std::vector<bool> published_;	// Groups to wake on the next notify(), only touched on the poll thread
+
+		// Stream starts sent by reconcile_devices(), one per device. Sized once, as the callbacks
+		// point into it. Only touched on the poll thread, like the devices that were listed with the wrong type.
+		struct StreamStart {
+			PSMRequestID request = 0;
+			PSMResult result = PSMResult_Success;
+			clock::time_point deadline;
+			bool pending = false;
+		};
+		std::vector<StreamStart> starts_;
+		std::vector<bool> wrong_type_;
+
+		// Connection watchdog state, only touched on the poll thread
+		bool connected_ = true;
+		clock::time_point last_frame_;
+		clock::time_point lost_at_;
+		std::chrono::milliseconds backoff_ = CONNECT_BACKOFF_MIN;
+
+		// Hot-plug state, only touched on the poll thread
+		clock::time_point next_rescan_ = clock::now() + HOTPLUG_RESCAN_INTERVAL;
+		bool controller_list_ready_ = false;
+		bool hmd_list_ready_ = false;
+		PSMControllerList controller_list_ = {};
+		PSMHmdList hmd_list_ = {};
+		bool replay_finished_ = false;
+
+		std::thread thread_;
+	};
+
+	// What every group's MoveDevice and every ImuDevice shares: the log thread, the one connection to
+	// PSMoveService and its poll thread, and the metrics reporter. The last device to go shuts it down.
+	struct PluginRuntime {
+		PluginRuntime(OSVR_PluginRegContext ctx, std::unique_ptr<FrameRecorder> frame_recorder):recorder(std::move(frame_recorder)), reporter(ctx), poller(ctx, reporter) {}
+		// Declared before the poll thread, so logging is still asynchronous while it shuts down
+		LogThread log_thread;
+		// Null unless recording. Declared before the poll thread too, which writes to it until it stops.
+		std::unique_ptr<FrameRecorder> recorder;
+		// Declared before the poll thread as well, which writes its reports
+		MetricsReporter reporter;
+		PsmPoller poller;
+	};
+
 	class MoveDevice {
 	public:
 
-		MoveDevice(OSVR_PluginRegContext ctx){
+		MoveDevice(OSVR_PluginRegContext ctx, size_t group, const std::shared_ptr<PluginRuntime>& runtime):m_ctx(ctx), m_group_index(group), m_group(*groups[group]), m_runtime(runtime){
 			OSVR_DeviceInitOptions opts = osvrDeviceCreateInitOptions(ctx);
 			Json::Value json_descriptor = generate_json_descriptor();
 			if (display_json) {
@@ -77,164 +2660,85 @@ namespace
 			osvrDeviceTrackerConfigure(opts, &m_tracker);
 			osvrDeviceButtonConfigure(opts, &m_buttons, json_descriptor["interfaces"]["button"]["count"].asInt());
 			osvrDeviceAnalogConfigure(opts, &m_analog, json_descriptor["interfaces"]["analog"]["count"].asInt());
-			m_dev.initAsync(ctx, DEVICE_NAME, opts);
+			m_button_values.resize(json_descriptor["interfaces"]["button"]["count"].asInt());
+			m_analog_values.resize(json_descriptor["interfaces"]["analog"]["count"].asInt());
+			m_batch.reserve(m_group.devices.size());
+			m_reports.reserve(m_group.devices.size());
+			m_queued.resize(m_group.devices.size(), -1);
+			for (size_t i = 0; i < m_group.devices.size(); i++) {
+				const DeviceRecord* device = m_group.devices[i];
+				if (device->type->tracked)
+					m_filters.configure(device->tracker, device->feed->settings.filter);
+				m_activity.configure(i, device->feed->settings.idle);
+			}
+			m_dev.initAsync(ctx, m_group.name, opts);
 			m_dev.sendJsonDescriptor(json_descriptor.toStyledString());
 			m_dev.registerUpdateCallback(this);
 		}
 
 		OSVR_ReturnCode update() {
-			PSM_UpdateNoPollMessages();
-
-			std::this_thread::sleep_for(std::chrono::milliseconds(10));
-			
-			int num_trackers = 0;
-			int num_analogs = 0;
-			int num_buttons = 0;
-
-			// Update Move Controllers
-			for (int i = 0; i < move_controllers.size(); i++) {
-				std::string& con_name = move_controllers.at(i).first;
-				PSMController* con = move_controllers.at(i).second;
-				
-				// Send Pose to Tracker
-				PSMPosef con_pose_p = con->ControllerState.PSMoveState.Pose;
-				OSVR_PoseState con_pose_o = psm_to_osvr_posestate(&con_pose_p);
-				osvrDeviceTrackerSendPose(m_dev, m_tracker, &con_pose_o, num_trackers++);
-
-				// Send analog (trigger) value
-				osvrDeviceAnalogSetValue(m_dev, m_analog, con->ControllerState.PSMoveState.TriggerValue, num_analogs++);
-
-				// Send button values
-				PSMButtonState con_button_states[] = {
-					con->ControllerState.PSMoveState.TriangleButton,
-					con->ControllerState.PSMoveState.CircleButton,
-					con->ControllerState.PSMoveState.CrossButton,
-					con->ControllerState.PSMoveState.SquareButton,
-					con->ControllerState.PSMoveState.SelectButton,
-					con->ControllerState.PSMoveState.StartButton,
-					con->ControllerState.PSMoveState.PSButton,
-					con->ControllerState.PSMoveState.MoveButton,
-					con->ControllerState.PSMoveState.TriggerButton
-				};
-				for (int j = 0; j < std::size(con_button_states); j++)
-					osvrDeviceButtonSetValue(m_dev, m_buttons, (con_button_states[j] == PSMButtonState_DOWN), num_buttons++);
-
-			}
-
-			for (int i = 0; i < navi_controllers.size(); i++) {
-				std::string& con_name = navi_controllers.at(i).first;
-				PSMController* con = navi_controllers.at(i).second;
-
-				// Send Analogs
-				int con_analog_states[] = {
-					con->ControllerState.PSNaviState.TriggerValue,
-					con->ControllerState.PSNaviState.Stick_XAxis,
-					con->ControllerState.PSNaviState.Stick_YAxis
-				};
-				for(int j = 0; j < std::size(con_analog_states); j++)
-					osvrDeviceAnalogSetValue(m_dev, m_analog, con_analog_states[j], num_analogs++);
-
-				// Send buttons
-				PSMButtonState con_button_states[] = {
-					con->ControllerState.PSNaviState.L1Button,
-					con->ControllerState.PSNaviState.L2Button,
-					con->ControllerState.PSNaviState.L3Button,
-					con->ControllerState.PSNaviState.CircleButton,
-					con->ControllerState.PSNaviState.CrossButton,
-					con->ControllerState.PSNaviState.PSButton,
-					con->ControllerState.PSNaviState.TriggerButton,
-					con->ControllerState.PSNaviState.DPadUpButton,
-					con->ControllerState.PSNaviState.DPadRightButton,
-					con->ControllerState.PSNaviState.DPadDownButton,
-					con->ControllerState.PSNaviState.DPadLeftButton
-				};
-				
-				for (int j = 0; j < std::size(con_button_states); j++)
-					osvrDeviceButtonSetValue(m_dev, m_buttons, (con_button_states[j] == PSMButtonState_DOWN), num_buttons++);
-			}
-
-			for (int i = 0; i < ds4_controllers.size(); i++) {
-				std::string& con_name = ds4_controllers.at(i).first;
-				PSMController* con = ds4_controllers.at(i).second;
-
-				// Send Pose to Tracker
-				PSMPosef con_pose_p = con->ControllerState.PSDS4State.Pose;
-				OSVR_PoseState con_pose_o = psm_to_osvr_posestate(&con_pose_p);
-				osvrDeviceTrackerSendPose(m_dev, m_tracker, &con_pose_o, num_trackers++);
-
-				// Send Analogs
-				int con_analog_states[] = {
-					(int)(255 * (con->ControllerState.PSDS4State.LeftAnalogX + 1) / 2),
-					(int)(255 * (con->ControllerState.PSDS4State.LeftAnalogY + 1) / 2),
-					(int)(255 * (con->ControllerState.PSDS4State.RightAnalogY + 1) / 2),
-					(int)(255 * (con->ControllerState.PSDS4State.RightAnalogY + 1) / 2),
-					(int)(255 * con->ControllerState.PSDS4State.LeftTriggerValue),
-					(int)(255 * con->ControllerState.PSDS4State.RightTriggerValue)
-				};
-				for (int j = 0; j < std::size(con_analog_states); j++)
-					osvrDeviceAnalogSetValue(m_dev, m_analog, con_analog_states[j], num_analogs++);
-
-				// Send Buttons
-				PSMButtonState con_button_states[] = {
-					con->ControllerState.PSDS4State.DPadUpButton,
-					con->ControllerState.PSDS4State.DPadDownButton,
-					con->ControllerState.PSDS4State.DPadLeftButton,
-					con->ControllerState.PSDS4State.DPadRightButton,
-					con->ControllerState.PSDS4State.SquareButton,
-					con->ControllerState.PSDS4State.CrossButton,
-					con->ControllerState.PSDS4State.CircleButton,
-					con->ControllerState.PSDS4State.TriangleButton,
-					con->ControllerState.PSDS4State.L1Button,
-					con->ControllerState.PSDS4State.R1Button,
-					con->ControllerState.PSDS4State.L2Button,
-					con->ControllerState.PSDS4State.R2Button,
-					con->ControllerState.PSDS4State.L3Button,
-					con->ControllerState.PSDS4State.R3Button,
-					con->ControllerState.PSDS4State.ShareButton,
-					con->ControllerState.PSDS4State.OptionsButton,
-					con->ControllerState.PSDS4State.PSButton,
-					con->ControllerState.PSDS4State.TrackPadButton
-				};
-				for (int j = 0; j < std::size(con_button_states); j++)
-					osvrDeviceButtonSetValue(m_dev, m_buttons, (con_button_states[j] == PSMButtonState_DOWN), num_buttons++);
-
+			wait_for_frame();
+
+			osvrTimeValueGetNow(&m_timestamp);
+			m_input_timestamp = {};
+			clock::time_point now = clock::now();
+			m_batch.clear();
+			m_reports.clear();
+			m_calls = 0;
+
+			for (size_t i = 0; i < m_group.devices.size(); i++) {
+				DeviceRecord* device = m_group.devices[i];
+
+				// Queue buttons and analogs into this device's channels
+				device->type->read(*device, now, m_button_values.data() + device->first_button, m_analog_values.data() + device->first_analog);
+				track_device(*device, now);
+				if (!device->connected)
+					m_activity.reset(i);
+
+				// Queue pose, velocity and acceleration for the Tracker, unless the device is idle
+				m_queued[i] = -1;
+				if (!device->type->tracked || !device->new_frame)
+					continue;
+				if (m_activity.admit(i, device->sample.pose, inputs_changed(device), now)) {
+					m_queued[i] = (int)m_reports.size();
+					queue_tracker(*device);
+				}
+				else {
+					device->feed->metrics.idle.add();
+				}
 			}
 
-			for (int i = 0; i < virtual_controllers.size(); i++) {
-				std::string& con_name = virtual_controllers.at(i).first;
-				PSMController* con = virtual_controllers.at(i).second;
-
-				// Send Pose to Tracker
-				PSMPosef con_pose_p = con->ControllerState.VirtualController.Pose;
-				OSVR_PoseState con_pose_o = psm_to_osvr_posestate(&con_pose_p);
-				osvrDeviceTrackerSendPose(m_dev, m_tracker, &con_pose_o, num_trackers++);
-
+			// Convert every queued pose into the OSVR room and smooth it, one pass each, then send them.
+			// Prediction comes last, so the filters only ever see measured poses.
+			clock::time_point stage_start = metrics_enabled ? clock::now() : now;
+			m_batch.transform(unit_scale, room_alignment);
+			m_filters.apply(m_batch, m_reports);
+			for (size_t i = 0; i < m_reports.size(); i++) {
+				if (m_reports[i].prediction > 0)
+					m_batch.predict(i, m_reports[i].prediction);
 			}
-
-			for (int i = 0; i < virtual_hmds.size(); i++) {
-				std::string& hmd_name = virtual_hmds.at(i).first;
-				PSMHeadMountedDisplay* hmd = virtual_hmds.at(i).second;
-				
-				// Send Pose to Tracker
-				PSMPosef con_pose_p = hmd->HmdState.VirtualHMDState.Pose;
-				OSVR_PoseState con_pose_o = psm_to_osvr_posestate(&con_pose_p);
-				osvrDeviceTrackerSendPose(m_dev, m_tracker, &con_pose_o, num_trackers++);
-
+			if (metrics_enabled) {
+				clock::time_point stage_end = clock::now();
+				m_group.metrics.convert.record(stage_end - stage_start);
+				stage_start = stage_end;
 			}
-
-			for (int i = 0; i < psvr_hmds.size(); i++) {
-				std::string& hmd_name = psvr_hmds.at(i).first;
-				PSMHeadMountedDisplay* hmd = psvr_hmds.at(i).second;
-
-				// Send Pose to Tracker
-				PSMPosef con_pose_p = hmd->HmdState.MorpheusState.Pose;
-				OSVR_PoseState con_pose_o = psm_to_osvr_posestate(&con_pose_p);
-				osvrDeviceTrackerSendPose(m_dev, m_tracker, &con_pose_o, num_trackers++);
-
+			send_trackers();
+
+			// Buttons and analogs carry no sample time of their own, so stamp them with the newest frame they came from
+			send_changed_channels(m_input_timestamp.seconds != 0 ? &m_input_timestamp : &m_timestamp);
+			if (pose_export)
+				export_devices();
+
+			if (metrics_enabled) {
+				clock::time_point end = clock::now();
+				m_group.metrics.send.record(end - stage_start);
+				m_group.metrics.tick_cost.record(end - now);
+				m_group.metrics.interval.record(now - m_last_tick);
+				m_group.metrics.ticks.add();
+				m_group.metrics.calls.add(m_calls);
+				m_runtime->reporter.report(now);
 			}
-
-
-
+			m_last_tick = now;
 
 			return OSVR_RETURN_SUCCESS;
 		}
@@ -244,16 +2748,181 @@ namespace
 		}
 
 	private:
+		OSVR_PluginRegContext m_ctx;
+		size_t m_group_index;
+		DeviceGroup& m_group;
+		// Declared before the device token, so the runtime outlives this device's update thread
+		std::shared_ptr<PluginRuntime> m_runtime;
 		osvr::pluginkit::DeviceToken m_dev;
 		OSVR_TrackerDeviceInterface m_tracker;
 		OSVR_ButtonDeviceInterface m_buttons;
 		OSVR_AnalogDeviceInterface m_analog;
+		clock::time_point m_deadline = clock::now();
+		unsigned long long m_seen_generation = 0;
+
+		// When this tick is being reported, and when the newest input frame in it arrived
+		OSVR_TimeValue m_timestamp = {};
+		OSVR_TimeValue m_input_timestamp = {};
+
+		// Metrics state: when the last tick started, and the OSVR calls made this tick
+		clock::time_point m_last_tick = clock::now();
+		unsigned int m_calls = 0;
+
+		// Tracker reports queued this tick, their poses in m_batch, and which report each device got if any
+		PoseBatch m_batch;
+		std::vector<TrackerReport> m_reports;
+		std::vector<int> m_queued;
+		PoseFilterBank m_filters;
+		ActivityGate m_activity;
+
+		// Queues a tracker's pose and derivatives from the frame PSMoveService just delivered
+		void queue_tracker(DeviceRecord& device) {
+			const DeviceSettings& settings = device.feed->settings;
+			const PSMPosef& pose = device.sample.pose;
+			const PSMPhysicsData& physics = device.sample.physics;
+			OSVR_TimeValue captured = device.captured(physics.TimeInSeconds);
+			device.record_latency(captured, m_timestamp);
+
+			// Without physics data there is nothing to predict from and no derivatives to send
+			const bool has_physics = (settings.stream_flags & PSMStreamFlags_includePhysicsData) != 0;
+			m_batch.add(pose, has_physics ? physics : PSMPhysicsData(), settings.offset);
+			const double prediction = has_physics ? settings.prediction_ms / 1000.0 : 0.0;
+			m_reports.push_back({ device.tracker, captured, has_physics, prediction,
+				prediction > 0 ? seconds_time_value(time_value_seconds(captured) + prediction) : captured });
+		}
+
+		// Whether any of the device's buttons or analogs differ from what was last sent to OSVR
+		bool inputs_changed(const DeviceRecord* device) const {
+			const size_t num_buttons = device->type->button_names.size();
+			const size_t num_analogs = device->type->analog_names.size();
+			if (num_buttons > 0 && (m_sent_button_values.empty() || !std::equal(m_button_values.begin() + device->first_button,
+				m_button_values.begin() + device->first_button + num_buttons, m_sent_button_values.begin() + device->first_button)))
+				return true;
+			return num_analogs > 0 && (m_sent_analog_values.empty() || !std::equal(m_analog_values.begin() + device->first_analog,
+				m_analog_values.begin() + device->first_analog + num_analogs, m_sent_analog_values.begin() + device->first_analog));
+		}
+
+		// Sends the converted poses, in the order they were queued, stamped with the time they predict
+		void send_trackers() {
+			for (size_t i = 0; i < m_reports.size(); i++) {
+				const TrackerReport& report = m_reports[i];
+				OSVR_PoseState pose_o = m_batch.pose(i);
+				osvrDeviceTrackerSendPoseTimestamped(m_dev, m_tracker, &pose_o, report.sensor, &report.stamp);
+				m_calls++;
+				if (!report.physics)
+					continue;
+				OSVR_VelocityState velocity_o = m_batch.velocity(i);
+				osvrDeviceTrackerSendVelocityTimestamped(m_dev, m_tracker, &velocity_o, report.sensor, &report.stamp);
+				OSVR_AccelerationState acceleration_o = m_batch.acceleration(i);
+				osvrDeviceTrackerSendAccelerationTimestamped(m_dev, m_tracker, &acceleration_o, report.sensor, &report.stamp);
+				m_calls += 2;
+			}
+		}
+
+		// Notes the newest input frame for this tick, and logs when a device stops delivering frames and when it comes back
+		void track_device(DeviceRecord& device, clock::time_point now) {
+			if (device.new_frame && time_value_seconds(device.received) > time_value_seconds(m_input_timestamp))
+				m_input_timestamp = device.received;
+			// Detached devices are logged by the poll thread, they can't go stale as well
+			if (!device.connected || !device.update_stale(now, stale_timeout))
+				return;
+			Logger log(m_ctx);
+			if (device.stale) {
+				log.get() << "Device \"" << device.name << "\" has not sent any data for "
+					<< std::chrono::duration_cast<std::chrono::milliseconds>(stale_timeout).count() << "ms, marking it stale.";
+				log.set_warning(true);
+			}
+			else {
+				log.get() << "Device \"" << device.name << "\" is sending data again.";
+			}
+			log.send();
+		}
+
+		// Channel values queued this tick, and the values OSVR last received
+		std::vector<OSVR_ButtonState> m_button_values;
+		std::vector<OSVR_AnalogState> m_analog_values;
+		std::vector<OSVR_ButtonState> m_sent_button_values;
+		std::vector<OSVR_AnalogState> m_sent_analog_values;
+
+		// Sends each interface's queued values as one batched report, but only if something changed
+		// since the last report. OSVR's batch calls always cover channels 0..count-1, so a single
+		// change resends the whole interface while an idle tick sends nothing at all.
+		void send_changed_channels(const OSVR_TimeValue* timestamp) {
+			if (!m_button_values.empty() && m_button_values != m_sent_button_values) {
+				osvrDeviceButtonSetValuesTimestamped(m_dev, m_buttons, m_button_values.data(), m_button_values.size(), timestamp);
+				m_sent_button_values = m_button_values;
+				m_calls++;
+			}
+			if (!m_analog_values.empty() && m_analog_values != m_sent_analog_values) {
+				osvrDeviceAnalogSetValuesTimestamped(m_dev, m_analog, m_analog_values.data(), m_analog_values.size(), timestamp);
+				m_sent_analog_values = m_analog_values;
+				m_calls++;
+			}
+		}
+
+		// Copies this tick's state of every device into its shared memory slot, including the poses just sent
+		void export_devices() {
+			for (size_t i = 0; i < m_group.devices.size(); i++) {
+				const DeviceRecord* device = m_group.devices[i];
+				ExportSlot& slot = pose_export->begin_write(device - devices.data());
+				slot.flags = device->connected ? (slot.flags | EXPORT_CONNECTED) : (slot.flags & ~EXPORT_CONNECTED);
+				if (m_queued[i] >= 0) {
+					const size_t report = m_queued[i];
+					const TrackerReport& tracker = m_reports[report];
+					slot.flags = (slot.flags | EXPORT_TRACKED) & ~EXPORT_PHYSICS;
+					if (tracker.physics)
+						slot.flags |= EXPORT_PHYSICS;
+					slot.sample_time = time_value_seconds(tracker.stamp);
+					const PoseBatch::Field fields[] = {
+						PoseBatch::PX, PoseBatch::PY, PoseBatch::PZ, PoseBatch::QW, PoseBatch::QX, PoseBatch::QY, PoseBatch::QZ,
+						PoseBatch::VX, PoseBatch::VY, PoseBatch::VZ, PoseBatch::WX, PoseBatch::WY, PoseBatch::WZ
+					};
+					double* values[] = {
+						&slot.position[0], &slot.position[1], &slot.position[2],
+						&slot.orientation[0], &slot.orientation[1], &slot.orientation[2], &slot.orientation[3],
+						&slot.linear_velocity[0], &slot.linear_velocity[1], &slot.linear_velocity[2],
+						&slot.angular_velocity[0], &slot.angular_velocity[1], &slot.angular_velocity[2]
+					};
+					for (size_t i = 0; i < 13; i++)
+						*values[i] = m_batch.get(fields[i], report);
+					slot.frames++;
+				}
+				slot.buttons = 0;
+				const size_t num_buttons = std::min<size_t>(device->type->button_names.size(), 32);
+				for (size_t j = 0; j < num_buttons; j++) {
+					if (m_button_values[device->first_button + j])
+						slot.buttons |= 1u << j;
+				}
+				slot.analog_count = (uint32_t)std::min<size_t>(device->type->analog_names.size(), 8);
+				for (size_t j = 0; j < slot.analog_count; j++)
+					slot.analogs[j] = (float)m_analog_values[device->first_analog + j];
+				pose_export->end_write(slot);
+			}
+		}
+
+		// Blocks until it is time to report again. Fixed mode wakes once per period; event mode wakes
+		// early as soon as the poll thread publishes a new frame for any device in this group.
+		void wait_for_frame() {
+			const clock::duration period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / m_group.rate_hz));
+			clock::time_point now = clock::now();
+
+			// Don't try to catch up on ticks we missed, just start a new period
+			m_deadline = (m_deadline + period < now) ? now + period : m_deadline + period;
+
+			if (m_group.mode == UpdateMode::Fixed) {
+				std::this_thread::sleep_until(m_deadline);
+				return;
+			}
 
+			m_runtime->poller.wait_for_frame(m_group_index, m_deadline, m_seen_generation);
+			// The next deadline counts from when we actually reported
+			m_deadline = clock::now();
+		}
 
 		Json::Value generate_json_descriptor() {
 			Json::Value descriptor;
 			descriptor["deviceVendor"] = "Sony";
-			descriptor["deviceName"] = DEVICE_NAME;
+			descriptor["deviceName"] = m_group.name;
 			descriptor["author"] = "InfiniteLlamas";
 			descriptor["version"] = "0.4a";
 			//descriptor["lastModified"] = std::string(__DATE__).append("T").append(__TIME__).append("Z");
@@ -264,86 +2933,28 @@ namespace
 			Json::Value tracker;
 			tracker["position"] = true;
 			tracker["orientation"] = true;
+			tracker["linearVelocity"] = true;
+			tracker["angularVelocity"] = true;
+			tracker["linearAcceleration"] = true;
+			tracker["angularAcceleration"] = true;
 			interfaces["tracker"] = tracker;
 
-			int num_trackers = 0;
-			int num_analogs = 0;
-			int num_buttons = 0;
-
-			// Move Controllers
-			for (int i = 0; i < move_controllers.size(); i++) {
-				
-				// Add tracker to semantic
-				semantic[move_controllers.at(i).first + "/tracker"] = "tracker/" + std::to_string(num_trackers++);
-				
-				// Add buttons to semantic
-				std::string button_names[] = { "/triangle","/circle","/cross","/square","/select","/start","/ps","/move","/triggerbtn" };
-				for (int j = 0; j < std::size(button_names); j++) {
-					semantic[move_controllers.at(i).first + button_names[j]] = "button/" + std::to_string(num_buttons++);
-				}
-
-				// Add analog (trigger) to semantic
-				semantic[move_controllers.at(i).first + "/trigger"] = "analog/" + std::to_string(num_analogs++);
-				
-			}
-
-			// Navigation Controllers
-			for (int i = 0; i < navi_controllers.size(); i++) {
-				
-				//Add buttons to semantic
-				std::string button_names[] = { "/l1","/l2","/l3","/circle","/cross","/ps","/triggerbtn","/dpadup","/dpadright","/dpaddown","/dpadleft" };
-				for (int j = 0; j < std::size(button_names); j++)
-					semantic[navi_controllers.at(i).first + button_names[j]] = "button/" + std::to_string(num_buttons++);
-				
-				//Add analogs to semantic
-				std::string analog_names[] = { "/trigger", "/stickx","/sticky" };
-				for (int j = 0; j < std::size(analog_names); j++)
-					semantic[navi_controllers.at(i).first + analog_names[j]] = "analog/" + std::to_string(num_analogs++);
-			}
-
-			// Ds4 Controllers
-			for (int i = 0; i < ds4_controllers.size(); i++) {
-
+			for (const DeviceRecord* device : m_group.devices) {
 				// Add tracker to semantic
-				semantic[ds4_controllers.at(i).first + "/tracker"] = "tracker/" + std::to_string(num_trackers++);
+				if (device->type->tracked)
+					semantic[device->name + "/tracker"] = "tracker/" + std::to_string(device->tracker);
 
-				//Add buttons to semantic
-				std::string button_names[] = { "/dpadup","/dpaddown","/dpadleft","/dpadright", "/square","/cross","/circle","/triangle","/l1","/r1","/l2","/r2","/l3","/r3","/share","/options","/ps","/trackpad" };
-				for (int j = 0; j < std::size(button_names); j++)
-					semantic[ds4_controllers.at(i).first + button_names[j]] = "button/" + std::to_string(num_buttons++);
-
-				//Add analogs to semantic
-				std::string analog_names[] = { "/lstickx", "/lsticky", "rstickx", "rsticky", "/ltrigger", "/rtrigger"};
-				for (int j = 0; j < std::size(analog_names); j++)
-					semantic[ds4_controllers.at(i).first + analog_names[j]] = "analog/" + std::to_string(num_analogs++);
-
-
-			}
-
-			// Virtual Controllers
-			for (int i = 0; i < virtual_controllers.size(); i++) {
-				// Add tracker to semantic
-				semantic[virtual_controllers.at(i).first + "/tracker"] = "tracker/" + std::to_string(num_trackers++);
-
-				// TODO: Do virtual controllers have buttons & analog inputs ?
-			}
-
-			// Virtual HMDs
-			for (int i = 0; i < virtual_hmds.size(); i++) {
-				// Add tracker to semantic
-				semantic[virtual_hmds.at(i).first + "/tracker"] = "tracker/" + std::to_string(num_trackers++);
-
-			}
-
-			// PSVR HMDs
-			for (int i = 0; i < psvr_hmds.size(); i++) {
-				// Add tracker to semantic
-				semantic[psvr_hmds.at(i).first + "/tracker"] = "tracker/" + std::to_string(num_trackers++);
+				// Add buttons to semantic
+				for (size_t j = 0; j < device->type->button_names.size(); j++)
+					semantic[device->name + device->type->button_names[j]] = "button/" + std::to_string(device->first_button + j);
 
+				// Add analogs to semantic
+				for (size_t j = 0; j < device->type->analog_names.size(); j++)
+					semantic[device->name + device->type->analog_names[j]] = "analog/" + std::to_string(device->first_analog + j);
 			}
 
 			Json::Value analog;
-			analog["count"] = num_analogs;
+			analog["count"] = m_group.num_analogs;
 			Json::Value traits(Json::arrayValue);
 			Json::Value trait_value;
 			trait_value["min"] = 0;
@@ -352,7 +2963,7 @@ namespace
 			analog["traits"] = traits;
 
 			Json::Value button;
-			button["count"] = num_buttons;
+			button["count"] = m_group.num_buttons;
 
 			
 			interfaces["analog"] = analog;
@@ -362,24 +2973,69 @@ namespace
 
 			return descriptor;
 		}
+	};
+
+	// Reports one device's IMU samples through an OSVR device of its own, each sample as a single
+	// batch of its six channels with its own timestamp. On the group's analog interface a batch would
+	// resend every other channel with that time, and channels set one by one tear the sample apart.
+	class ImuDevice {
+	public:
+		ImuDevice(OSVR_PluginRegContext ctx, const DeviceRecord& device, const std::shared_ptr<PluginRuntime>& runtime):m_device(device), m_runtime(runtime) {
+			OSVR_DeviceInitOptions opts = osvrDeviceCreateInitOptions(ctx);
+			Json::Value json_descriptor = generate_json_descriptor();
+			if (display_json) {
+				Logger log(ctx);
+				log.get() << json_descriptor.toStyledString();
+				log.send();
+			}
+			osvrDeviceAnalogConfigure(opts, &m_analog, IMU_CHANNELS);
+			m_dev.initAsync(ctx, m_device.name + IMU_DEVICE_SUFFIX, opts);
+			m_dev.sendJsonDescriptor(json_descriptor.toStyledString());
+			m_dev.registerUpdateCallback(this);
+		}
 
-		OSVR_PoseState psm_to_osvr_posestate(const PSMPosef *psm_pose) {
-			OSVR_PoseState pstate;
-			osvrQuatSetIdentity(&(pstate.rotation));
-			osvrVec3Zero(&(pstate.translation));
+		// Sends every sample that arrived since the last call, oldest first, then sleeps until the
+		// poll thread publishes a frame for the device's group
+		OSVR_ReturnCode update() {
+			ImuSample sample;
+			OSVR_TimeValue captured;
+			while (m_device.feed->pop_imu(sample, captured)) {
+				OSVR_AnalogState values[IMU_CHANNELS];
+				for (size_t j = 0; j < IMU_CHANNELS; j++)
+					values[j] = (j < 3 ? sample.accelerometer : sample.gyroscope)[j % 3];
+				osvrDeviceAnalogSetValuesTimestamped(m_dev, m_analog, values, IMU_CHANNELS, &captured);
+			}
+			m_runtime->poller.wait_for_frame(m_device.group, clock::now() + MAX_WAIT, m_seen_generation);
+			return OSVR_RETURN_SUCCESS;
+		}
 
-			// To convert PSMS Meters into OSVR Centimeters
-			osvrVec3SetX(&(pstate.translation), (psm_pose->Position.x / 100.0));
-			osvrVec3SetY(&(pstate.translation), (psm_pose->Position.y / 100.0));
-			osvrVec3SetZ(&(pstate.translation), (psm_pose->Position.z / 100.0));
+	private:
+		// Wakes up this often without frames, so the update thread can still be stopped
+		static constexpr std::chrono::milliseconds MAX_WAIT{ 100 };
 
-			// Just pass straight through for now
-			osvrQuatSetW(&(pstate.rotation), psm_pose->Orientation.w); //w
-			osvrQuatSetX(&(pstate.rotation), psm_pose->Orientation.x); //x
-			osvrQuatSetY(&(pstate.rotation), psm_pose->Orientation.y); //y
-			osvrQuatSetZ(&(pstate.rotation), psm_pose->Orientation.z); //z
+		const DeviceRecord& m_device;
+		// Declared before the device token, so the runtime outlives this device's update thread
+		std::shared_ptr<PluginRuntime> m_runtime;
+		osvr::pluginkit::DeviceToken m_dev;
+		OSVR_AnalogDeviceInterface m_analog;
+		unsigned long long m_seen_generation = 0;
 
-			return pstate;
+		Json::Value generate_json_descriptor() {
+			Json::Value descriptor;
+			descriptor["deviceVendor"] = "Sony";
+			descriptor["deviceName"] = m_device.name + IMU_DEVICE_SUFFIX;
+			descriptor["author"] = "InfiniteLlamas";
+			descriptor["version"] = "0.4a";
+
+			Json::Value semantic;
+			for (size_t j = 0; j < IMU_CHANNELS; j++)
+				semantic[IMU_CHANNEL_NAMES[j]] = "analog/" + std::to_string(j);
+
+			Json::Value analog;
+			analog["count"] = (Json::UInt)IMU_CHANNELS;
+			descriptor["interfaces"]["analog"] = analog;
+			descriptor["semantic"] = semantic;
+			return descriptor;
 		}
 	};
 
@@ -388,28 +3044,6 @@ namespace
 		OSVR_ReturnCode operator()(OSVR_PluginRegContext ctx, const char *params) {
 			Logger log(ctx);
 
-			log.get() << "Attempting connection with PSMoveService...";
-			log.send();
-
-			// Attempt to connect to the PSMoveService server
-			for (int i = 0; i < 5; i++) {
-				
-				log.get() << "Attempt " << (i+1);
-				log.send();
-				
-				PSMResult result = PSM_Initialize(PSMOVESERVICE_DEFAULT_ADDRESS, PSMOVESERVICE_DEFAULT_PORT, PSM_DEFAULT_TIMEOUT);
-				
-				if (result == PSMResult_Success)
-					break;
-
-				if (i == 4) {
-					log.get() << "Failed to connect to PSMoveService with error: [" << result << "] " << psm_error_str(result);
-					log.set_warning(true);
-					log.send();
-					return OSVR_RETURN_FAILURE;
-				}
-			}
-
 			// Returns array index value appears at, -1 if it doesnt appear in the array
 			auto find = [](int* arr, int count, int value) -> int {
 				for (int i = 0; i < count; i++) {
@@ -421,8 +3055,7 @@ namespace
 
 			// Attempt to connect all requested controllers
 			Json::Value config_params;
-			log.get() << "Attempting connection with controllers/HMDs...";
-			log.send();
+			std::unique_ptr<FrameRecorder> frame_recorder;
 			if (params) {
 				Json::Reader reader;
 				bool parse_result = reader.parse(params, config_params);
@@ -434,10 +3067,121 @@ namespace
 				}
 				try {
 					display_json = config_params.get("debug", false).asBool();
+
+					// The top level pace is the default group's, and where the other groups start from
+					groups.clear();
+					groups.emplace_back(new DeviceGroup());
+					groups[0]->name = DEVICE_NAME;
+					if (!parse_pace(log, config_params, *groups[0]))
+						return OSVR_RETURN_FAILURE;
+					const Json::Value& group_config = config_params["groups"];
+					for (const std::string& group_name : group_config.getMemberNames()) {
+						if (group_name == DEVICE_NAME) {
+							log.get() << "The group name \"" << DEVICE_NAME << "\" is taken by devices without a group, please pick another.";
+							log.set_warning(true);
+							log.send();
+							return OSVR_RETURN_FAILURE;
+						}
+						groups.emplace_back(new DeviceGroup());
+						groups.back()->name = group_name;
+						groups.back()->mode = groups[0]->mode;
+						groups.back()->rate_hz = groups[0]->rate_hz;
+						if (!parse_pace(log, group_config[group_name], *groups.back()))
+							return OSVR_RETURN_FAILURE;
+					}
+					stale_timeout = std::chrono::milliseconds(config_params.get("stale_timeout_ms", 500).asInt());
+					watchdog_timeout = std::chrono::milliseconds(config_params.get("watchdog_timeout_ms", 2000).asInt());
+					const Json::Value& metrics = config_params["metrics"];
+					metrics_interval = std::chrono::milliseconds((long long)(metrics.get("interval_s", 10.0).asDouble() * 1000));
+					metrics_file = metrics.get("file", "").asString();
+					metrics_enabled = display_json || !metrics_file.empty();
+					unit_scale = config_params.get("unit_scale", 0.01).asFloat();
+					if (config_params.isMember("alignment") && !parse_transform(config_params["alignment"], room_alignment)) {
+						log.get() << "Invalid alignment, it needs a 3 element position and/or a non-zero 4 element orientation.";
+						log.set_warning(true);
+						log.send();
+						return OSVR_RETURN_FAILURE;
+					}
+
+					const Json::Value& server = config_params["server"];
+					server_address = server.get("address", PSMOVESERVICE_DEFAULT_ADDRESS).asString();
+					const Json::Value& port = server["port"];
+					server_port = port.isNull() ? PSMOVESERVICE_DEFAULT_PORT : port.isNumeric() ? std::to_string(port.asUInt()) : port.asString();
+
+					startup_timeout = std::chrono::milliseconds(config_params.get("startup_timeout_ms", 10000).asInt());
+					const clock::time_point startup_deadline = clock::now() + startup_timeout;
+
+					const Json::Value& record = config_params["record"];
+					if (!record.isNull()) {
+						const std::string file = record.get("file", "").asString();
+						frame_recorder.reset(new FrameRecorder());
+						if (!frame_recorder->open(file)) {
+							frame_recorder.reset();
+							log.get() << "Could not create the recording \"" << file << "\".";
+							log.set_warning(true);
+							log.send();
+							return OSVR_RETURN_FAILURE;
+						}
+						log.get() << "Recording PSMoveService frames to \"" << file << "\".";
+						log.send();
+					}
+
 					PSMHmdList hmd_list;
 					PSMControllerList con_list;
-					PSM_GetHmdList(&hmd_list, 5000);
-					PSM_GetControllerList(&con_list, 5000);
+					clock::time_point phase_start = clock::now();
+					const Json::Value& replay = config_params["replay"];
+					if (!replay.isNull()) {
+						const std::string file = replay.get("file", "").asString();
+						const std::string speed = replay.get("speed", "realtime").asString();
+						if (speed != "realtime" && speed != "fast") {
+							log.get() << "Unknown replay speed \"" << speed << "\", valid speeds are realtime and fast.";
+							log.set_warning(true);
+							log.send();
+							return OSVR_RETURN_FAILURE;
+						}
+						frame_replayer.reset(new FrameReplayer());
+						std::string error;
+						if (!frame_replayer->load(file, speed == "realtime", error)) {
+							frame_replayer.reset();
+							log.get() << "Could not replay \"" << file << "\", " << error << ".";
+							log.set_warning(true);
+							log.send();
+							return OSVR_RETURN_FAILURE;
+						}
+						frame_replayer->device_lists(con_list, hmd_list);
+						log_phase(log, "Loaded \"" + file + "\" to replay instead of PSMoveService", phase_start);
+					}
+					else {
+						if (!connect(log, startup_deadline))
+							return OSVR_RETURN_FAILURE;
+						log_phase(log, "Connected to PSMoveService", phase_start);
+
+						phase_start = clock::now();
+						PSMResult hmd_result = PSM_GetHmdList(&hmd_list, remaining_ms(startup_deadline));
+						PSMResult con_result = PSM_GetControllerList(&con_list, remaining_ms(startup_deadline));
+						if (hmd_result != PSMResult_Success || con_result != PSMResult_Success) {
+							PSMResult result = (hmd_result != PSMResult_Success) ? hmd_result : con_result;
+							log.get() << "Failed to fetch the controller/HMD lists with error: [" << result << "] " << psm_error_str(result);
+							log.set_warning(true);
+							log.send();
+							return OSVR_RETURN_FAILURE;
+						}
+						log_phase(log, "Fetched controller/HMD lists", phase_start);
+					}
+
+					log.get() << "Attempting connection with controllers/HMDs...";
+					log.send();
+					phase_start = clock::now();
+					std::vector<std::pair<size_t, PSMRequestID>> stream_requests;	// Index in devices, and the request
+
+					// The top level "idle" applies to every device that doesn't have its own
+					IdleSettings idle;
+					if (config_params.isMember("idle") && !parse_idle(config_params["idle"], idle)) {
+						log.get() << "Invalid idle settings, the thresholds can't be negative and keepalive_hz must be greater than 0.";
+						log.set_warning(true);
+						log.send();
+						return OSVR_RETURN_FAILURE;
+					}
 
 					for (Json::Value controller : config_params["controllers"]) {
 
@@ -445,102 +3189,120 @@ namespace
 						std::string controller_type = controller["type"].asString();
 						int controller_id = controller.get("id", -1).asInt();
 
-						log.get() << "Parsing device " << controller_name << " as a " << controller_type;
-						log.send();
-
-						int con_pos = find(con_list.controller_id, con_list.count, controller_id);
-						int hmd_pos = find(hmd_list.hmd_id, hmd_list.count, controller_id);
-
-						if (con_pos == -1 && hmd_pos == -1) {
-							log.get() << "Controller or HMD [id:" << controller_id << "] \"" << controller_name << "\" is not connected, please connect the controller or HMD and restart OSVR.";
+						DeviceSettings settings;
+						settings.prediction_ms = controller.get("prediction_ms", 0.0).asDouble();
+						if (controller.isMember("offset") && !parse_transform(controller["offset"], settings.offset)) {
+							log.get() << "Invalid offset for device " << controller_name << ", it needs a 3 element position and/or a non-zero 4 element orientation.";
 							log.set_warning(true);
 							log.send();
 							return OSVR_RETURN_FAILURE;
 						}
-						if (controller_type.compare("Move") == 0) { // We are looking for a move controller
-							if (con_list.controller_type[con_pos] != PSMController_Move) {
-								log.get() << "Controller [id:" << controller_id << "] \"" << controller_name << "\" is not a Move controller, please correct this and restart OSVR.";
-								log.set_warning(true);
-								log.send();
-								return OSVR_RETURN_FAILURE;
-							}
-							PSMController* move_controller = PSM_GetController(controller_id);
-							PSM_AllocateControllerListener(controller_id);
-							PSM_StartControllerDataStream(controller_id, PSMStreamFlags_includePositionData | PSMStreamFlags_includeCalibratedSensorData | PSMStreamFlags_includePhysicsData, 5000);
-							move_controllers.emplace_back(std::make_pair(controller_name, move_controller));
+						settings.idle = idle;
+						if (controller.isMember("idle") && !parse_idle(controller["idle"], settings.idle)) {
+							log.get() << "Invalid idle settings for device " << controller_name << ", the thresholds can't be negative and keepalive_hz must be greater than 0.";
+							log.set_warning(true);
+							log.send();
+							return OSVR_RETURN_FAILURE;
 						}
-						else if (controller_type.compare("Navi") == 0) { // We are looking for a navigation controller
-							if (con_list.controller_type[con_pos] != PSMController_Navi) {
-								log.get() << "Controller [id:" << controller_id << "] \"" << controller_name << "\" is not a Navigation controller, please correct this and restart OSVR.";
-								log.set_warning(true);
-								log.send();
-								return OSVR_RETURN_FAILURE;
-							}
-							PSMController* navi_controller = PSM_GetController(controller_id);
-							PSM_AllocateControllerListener(controller_id);
-							PSM_StartControllerDataStream(controller_id, PSMStreamFlags_includePositionData | PSMStreamFlags_includeCalibratedSensorData | PSMStreamFlags_includePhysicsData, 5000);
-							navi_controllers.emplace_back(std::make_pair(controller_name, navi_controller));
+						if (controller.isMember("filter") && !parse_filter(controller["filter"], settings.filter)) {
+							log.get() << "Invalid filter for device " << controller_name << ", the type must be one_euro, adaptive or none and the cutoffs greater than 0.";
+							log.set_warning(true);
+							log.send();
+							return OSVR_RETURN_FAILURE;
 						}
-						else if (controller_type.compare("DualShock4") == 0) { // We are looking for a ds4 controller
-							if (con_list.controller_type[con_pos] != PSMController_DualShock4) {
-								log.get() << "Controller [id:" << controller_id << "] \"" << controller_name << "\" is not a DualShock4 controller, please correct this and restart OSVR.";
-								log.set_warning(true);
-								log.send();
-								return OSVR_RETURN_FAILURE;
-							}
-							PSMController* ds4_controller = PSM_GetController(controller_id);
-							PSM_AllocateControllerListener(controller_id);
-							PSM_StartControllerDataStream(controller_id, PSMStreamFlags_includePositionData | PSMStreamFlags_includeCalibratedSensorData | PSMStreamFlags_includePhysicsData, 5000);
-							ds4_controllers.emplace_back(std::make_pair(controller_name, ds4_controller));
+
+						log.get() << "Parsing device " << controller_name << " as a " << controller_type;
+						log.send();
+
+						const DeviceType* type = find_device_type(controller_type);
+						if (!type) {
+							log.get() << "Unknown controller/HMD type \"" << controller_type << "\" for controller id " << controller_id;
+							log.set_warning(true);
+							log.send();
+							log.get() << "Valid types are ";
+							for (size_t i = 0; i < device_types().size(); i++)
+								log.get() << (i == 0 ? "" : (i + 1 == device_types().size() ? ", and " : ", ")) << device_types()[i].type_name;
+							log.get() << ".";
+							log.set_warning(true);
+							log.send();
+							return OSVR_RETURN_FAILURE;
 						}
-						else if (controller_type.compare("VirtualMove") == 0) { // We are looking for a virtual controller
-							if (con_list.controller_type[con_pos] != PSMController_Virtual) {
-								log.get() << "Controller [id:" << controller_id << "] \"" << controller_name << "\" is not a VirtualMove controller, please correct this and restart OSVR.";
+
+						int pos = type->hmd ? find(hmd_list.hmd_id, hmd_list.count, controller_id) : find(con_list.controller_id, con_list.count, controller_id);
+						if (pos != -1) {
+							int connected_type = type->hmd ? (int)hmd_list.hmd_type[pos] : (int)con_list.controller_type[pos];
+							if (connected_type != type->psm_type) {
+								log.get() << (type->hmd ? "HMD" : "Controller") << " [id:" << controller_id << "] \"" << controller_name << "\" is not a " << type->description << ", please correct this and restart OSVR.";
 								log.set_warning(true);
 								log.send();
 								return OSVR_RETURN_FAILURE;
 							}
-							PSMController* virtual_controller = PSM_GetController(controller_id);
-							PSM_AllocateControllerListener(controller_id);
-							PSM_StartControllerDataStream(controller_id, PSMStreamFlags_includePositionData | PSMStreamFlags_includeCalibratedSensorData | PSMStreamFlags_includePhysicsData, 5000);
-							virtual_controllers.emplace_back(std::make_pair(controller_name, virtual_controller));
 						}
-						else if (controller_type.compare("VirtualHMD") == 0) { // We are looking for a virtual HMD
-							if (hmd_list.hmd_type[hmd_pos] != PSMHmd_Virtual) {
-								log.get() << "HMD [id:" << controller_id << "] \"" << controller_name << "\" is not a VirtualHMD HMD, please correct this and restart OSVR.";
-								log.set_warning(true);
-								log.send();
-								return OSVR_RETURN_FAILURE;
-							}
-							PSMHeadMountedDisplay* virtual_hmd = PSM_GetHmd(controller_id);
-							PSM_AllocateHmdListener(controller_id);
-							PSM_StartHmdDataStream(controller_id, PSMStreamFlags_includePositionData | PSMStreamFlags_includeCalibratedSensorData | PSMStreamFlags_includePhysicsData, 5000);
-							virtual_hmds.emplace_back(std::make_pair(controller_name, virtual_hmd));
 
+						settings.stream_flags = type->stream_flags;
+						std::string unknown_flag;
+						if (controller.isMember("stream") && !parse_stream_flags(controller["stream"], settings.stream_flags, unknown_flag)) {
+							log.get() << "Unknown stream option \"" << unknown_flag << "\" for \"" << controller_name << "\", valid options are position, physics, raw_sensor, calibrated_sensor, and raw_tracker.";
+							log.set_warning(true);
+							log.send();
+							return OSVR_RETURN_FAILURE;
 						}
-						else if (controller_type.compare("PSVR") == 0) { // We are looking for a Morpheus headset
-							if (hmd_list.hmd_type[hmd_pos] != PSMHmd_Virtual) {
-								log.get() << "HMD [id:" << controller_id << "] \"" << controller_name << "\" is not a PSVR HMD, please correct this and restart OSVR.";
+
+						DeviceRecord device;
+						device.name = controller_name;
+						device.id = controller_id;
+						device.type = type;
+						device.imu = type->imu && (settings.stream_flags & PSMStreamFlags_includeCalibratedSensorData) != 0;
+						device.group = 0;
+						if (controller.isMember("group")) {
+							const std::string group_name = controller["group"].asString();
+							auto group = std::find_if(groups.begin() + 1, groups.end(), [&group_name](const std::unique_ptr<DeviceGroup>& group) { return group->name == group_name; });
+							if (group == groups.end()) {
+								log.get() << "Unknown group \"" << group_name << "\" for \"" << controller_name << "\", groups have to be listed in \"groups\".";
 								log.set_warning(true);
 								log.send();
 								return OSVR_RETURN_FAILURE;
 							}
-							PSMHeadMountedDisplay* psvr_hmd = PSM_GetHmd(controller_id);
-							PSM_AllocateHmdListener(controller_id);
-							PSM_StartHmdDataStream(controller_id, PSMStreamFlags_includePositionData | PSMStreamFlags_includeCalibratedSensorData | PSMStreamFlags_includePhysicsData, 5000);
-							psvr_hmds.emplace_back(std::make_pair(controller_name, psvr_hmd));
+							device.group = group - groups.begin();
 						}
-						else {
-							log.get() << "Unknown controller/HMD type \"" << controller_type << "\" for controller id " << controller_id;
+						device.feed = type->make_feed(controller_id, settings, frame_recorder.get());
+
+						// Missing devices keep their channels and are attached by the poll thread once they connect
+						if (pos == -1) {
+							log.get() << "Controller or HMD [id:" << controller_id << "] \"" << controller_name << "\" is not connected, it will be attached once it connects.";
 							log.set_warning(true);
 							log.send();
-							log.get() << "Valid types are Move, Navi, DualShock4, VirtualMove, VirtualHMD, and PSVR." ;
+						}
+						else {
+							PSMRequestID request;
+							const PSMResult result = device.feed->attach(&request);
+							if (result == PSMResult_RequestSent)
+								stream_requests.push_back(std::make_pair(devices.size(), request));
+							else if (result != PSMResult_Success)
+								detach_failed_stream(log, device, result);
+						}
+						devices.push_back(std::move(device));
+					}
+					wait_for_streams(log, stream_requests, startup_deadline);
+					log_phase(log, "Started " + std::to_string(stream_requests.size()) + " device streams", phase_start);
+					assign_channels();
+
+					const Json::Value& shared_memory = config_params["shared_memory"];
+					if (!shared_memory.isNull()) {
+						const std::string name = shared_memory.get("name", "inf_osvr_move").asString();
+						pose_export.reset(new PoseExport());
+						std::string error;
+						if (!pose_export->open(name, devices.size(), error)) {
+							pose_export.reset();
+							log.get() << "Could not create the shared memory export \"" << name << "\", " << error << ".";
 							log.set_warning(true);
 							log.send();
 							return OSVR_RETURN_FAILURE;
 						}
-
-
+						for (size_t i = 0; i < devices.size(); i++)
+							pose_export->set_path(i, "/inf_osvr_move/" + groups[devices[i].group]->name + "/semantic/" + devices[i].name);
+						log.get() << "Exporting device state to shared memory \"" << name << "\".";
+						log.send();
 					}
 				}
 				catch (Json::Exception exc) {
@@ -560,9 +3322,112 @@ namespace
 			log.get() << "Parsed all controllers/HMDs successfully.";
 			log.send();
 
-			osvr::pluginkit::registerObjectForDeletion(ctx, new MoveDevice(ctx));
+			// One OSVR device, with its own update thread, per group that has devices, and one more for
+			// each device streaming its IMU
+			std::shared_ptr<PluginRuntime> runtime = std::make_shared<PluginRuntime>(ctx, std::move(frame_recorder));
+			for (size_t i = 0; i < groups.size(); i++) {
+				if (!groups[i]->devices.empty())
+					osvr::pluginkit::registerObjectForDeletion(ctx, new MoveDevice(ctx, i, runtime));
+			}
+			for (const DeviceRecord& device : devices) {
+				if (device.imu)
+					osvr::pluginkit::registerObjectForDeletion(ctx, new ImuDevice(ctx, device, runtime));
+			}
 			return OSVR_RETURN_SUCCESS;
 		}
+
+	private:
+		// Reads a "mode" and "rate_hz" pair into the group, keeping what it has for anything not given
+		static bool parse_pace(Logger& log, const Json::Value& config, DeviceGroup& group) {
+			std::string mode = config.get("mode", group.mode == UpdateMode::Event ? "event" : "fixed").asString();
+			if (mode.compare("fixed") == 0)
+				group.mode = UpdateMode::Fixed;
+			else if (mode.compare("event") == 0)
+				group.mode = UpdateMode::Event;
+			else {
+				log.get() << "Unknown update mode \"" << mode << "\" for " << group.name << ", valid modes are fixed and event.";
+				log.set_warning(true);
+				log.send();
+				return false;
+			}
+			group.rate_hz = config.get("rate_hz", group.rate_hz).asDouble();
+			if (group.rate_hz <= 0) {
+				log.get() << "Invalid rate_hz " << group.rate_hz << " for " << group.name << ", it must be greater than 0.";
+				log.set_warning(true);
+				log.send();
+				return false;
+			}
+			return true;
+		}
+
+		static int remaining_ms(clock::time_point deadline) {
+			return (int)std::max<long long>(0, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count());
+		}
+
+		static void log_phase(Logger& log, const std::string& phase, clock::time_point start) {
+			log.get() << phase << " in " << std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count() << "ms.";
+			log.send();
+		}
+
+		// Connects to PSMoveService, backing off exponentially between attempts until the deadline
+		static bool connect(Logger& log, clock::time_point deadline) {
+			log.get() << "Attempting connection with PSMoveService at " << server_address << ":" << server_port << "...";
+			log.send();
+
+			std::chrono::milliseconds backoff = CONNECT_BACKOFF_MIN;
+			for (int i = 0; ; i++) {
+
+				log.get() << "Attempt " << (i+1);
+				log.send();
+
+				PSMResult result = PSM_Initialize(server_address.c_str(), server_port.c_str(), std::min(PSM_DEFAULT_TIMEOUT, remaining_ms(deadline)));
+
+				if (result == PSMResult_Success)
+					return true;
+
+				if (clock::now() + backoff >= deadline) {
+					log.get() << "Failed to connect to PSMoveService with error: [" << result << "] " << psm_error_str(result);
+					log.set_warning(true);
+					log.send();
+					return false;
+				}
+				std::this_thread::sleep_for(backoff);
+				backoff = std::min(backoff * 2, CONNECT_BACKOFF_MAX);
+			}
+		}
+
+		// Waits for the asynchronous stream start requests to be answered, all at once, until the deadline.
+		// Devices whose stream didn't start are detached again, and the poll thread retries them.
+		static void wait_for_streams(Logger& log, const std::vector<std::pair<size_t, PSMRequestID>>& requests, clock::time_point deadline) {
+			std::vector<PSMResult> results(requests.size(), PSMResult_RequestSent);
+			auto on_response = [](const PSMResponseMessage* response, void* userdata) {
+				*static_cast<PSMResult*>(userdata) = response->result_code;
+			};
+			for (size_t i = 0; i < requests.size(); i++)
+				PSM_RegisterCallback(requests[i].second, on_response, &results[i]);
+
+			auto pending = [&results]() {
+				return std::count(results.begin(), results.end(), PSMResult_RequestSent) > 0;
+			};
+			// The poll thread doesn't exist yet, so publish the frames that arrive meanwhile here,
+			// or their IMU samples would be lost
+			while (pending() && clock::now() < deadline) {
+				PSM_UpdateNoPollMessages();
+				for (DeviceRecord& device : devices)
+					device.feed->pump();
+				std::this_thread::sleep_for(POLL_INTERVAL);
+			}
+
+			for (size_t i = 0; i < requests.size(); i++) {
+				if (results[i] == PSMResult_Success)
+					continue;
+				if (results[i] == PSMResult_RequestSent) {
+					PSM_CancelCallback(requests[i].second);
+					results[i] = PSMResult_Timeout;
+				}
+				detach_failed_stream(log, devices[requests[i].first], results[i]);
+			}
+		}
 	};
 
 } // namespace
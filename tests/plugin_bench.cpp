@@ -0,0 +1,174 @@
+// Benchmark for inf_osvr_move.cpp, built against the stand-ins in stand_in/ like plugin_tests.cpp.
+// Runs a Move, a Navi, a DualShock4 and a VirtualHMD from the synthetic service through the plugin
+// with its metrics on, then prints what a tick costs, how many OSVR calls it makes, how late poses
+// are and how steady the reporting is, followed by the pose transform, filter and prediction stage on its own.
+//
+// Usage: inf_osvr_move_bench [--seconds N] [--mode event|fixed] [--rate-hz HZ] [--frame-rate-hz HZ]
+#include "../inf_osvr_move.cpp"
+
+#include "stand_in.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+	struct BenchOptions {
+		double seconds = 5;
+		std::string mode = "event";
+		double rate_hz = 1000;
+		double frame_rate_hz = 120;
+	};
+
+	bool parse_options(int argc, char** argv, BenchOptions& options) {
+		for (int i = 1; i < argc; i++) {
+			const std::string option = argv[i];
+			if (i + 1 >= argc)
+				return false;
+			const char* value = argv[++i];
+			if (option == "--seconds")
+				options.seconds = std::atof(value);
+			else if (option == "--mode")
+				options.mode = value;
+			else if (option == "--rate-hz")
+				options.rate_hz = std::atof(value);
+			else if (option == "--frame-rate-hz")
+				options.frame_rate_hz = std::atof(value);
+			else
+				return false;
+		}
+		return options.seconds > 0 && options.rate_hz > 0 && options.frame_rate_hz >= 0;
+	}
+
+	void print_histogram(const char* name, const Histogram::Snapshot& snapshot) {
+		const uint64_t count = snapshot.count();
+		std::printf("  %-12s p50 %6llu us  p90 %6llu us  p99 %6llu us  max %6llu us  mean %8.1f us  (%llu)\n", name,
+			(unsigned long long)snapshot.percentile(50), (unsigned long long)snapshot.percentile(90),
+			(unsigned long long)snapshot.percentile(99), (unsigned long long)snapshot.percentile(100),
+			count ? (double)snapshot.sum_us / count : 0.0, (unsigned long long)count);
+	}
+
+	// The transform, filter and prediction stage alone, on a batch of every tracked device, as update() runs it
+	void bench_pose_kernel(size_t count, double seconds) {
+		PoseBatch batch;
+		batch.reserve(count);
+		PoseFilterBank filters;
+		FilterSettings filter;
+		filter.type = FilterType::OneEuro;
+		std::vector<TrackerReport> reports(count);
+		for (size_t i = 0; i < count; i++) {
+			filters.configure(i, filter);
+			reports[i] = { (OSVR_ChannelCount)i, {}, true, 0.01, {} };
+		}
+		RigidTransform alignment;
+		alignment.position[1] = 0.5f;
+		PSMPhysicsData physics = {};
+		physics.AngularVelocityRadPerSec.y = 1;
+		std::vector<PSMPosef> poses(256);
+		for (size_t i = 0; i < poses.size(); i++)
+			poses[i] = stand_in::synthetic_pose(i * 0.01);
+
+		uint64_t iterations = 0;
+		const clock::time_point start = clock::now();
+		clock::duration elapsed;
+		do {
+			for (int repeat = 0; repeat < 1000; repeat++, iterations++) {
+				const double t = iterations * 0.001;
+				batch.clear();
+				for (size_t i = 0; i < count; i++) {
+					batch.add(poses[(iterations + i) % poses.size()], physics, RigidTransform());
+					reports[i].captured = seconds_time_value(100.0 + t);
+				}
+				batch.transform(unit_scale, alignment);
+				filters.apply(batch, reports);
+				for (size_t i = 0; i < count; i++)
+					batch.predict(i, reports[i].prediction);
+			}
+			elapsed = clock::now() - start;
+		} while (elapsed < std::chrono::duration<double>(seconds));
+		const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+		std::printf("Pose stage (%s lanes): %zu poses per batch, %.1f ns per batch, %.1f ns per pose\n",
+			POSE_BATCH_SSE ? "SSE" : "scalar", count, ns / iterations, ns / (iterations * count));
+	}
+}
+
+int main(int argc, char** argv) {
+	BenchOptions options;
+	if (!parse_options(argc, argv, options) || (options.mode != "event" && options.mode != "fixed")) {
+		std::fprintf(stderr, "Usage: %s [--seconds N] [--mode event|fixed] [--rate-hz HZ] [--frame-rate-hz HZ]\n", argv[0]);
+		return 2;
+	}
+
+	stand_in::reset();
+	stand_in::keep_reports(false);
+	stand_in::set_frame_rate(options.frame_rate_hz);
+	stand_in::connect_controller(0, PSMController_Move);
+	stand_in::connect_controller(1, PSMController_Navi);
+	stand_in::connect_controller(2, PSMController_DualShock4);
+	stand_in::connect_hmd(0, PSMHmd_Virtual);
+
+	// Metrics go to the debug log, which the stand-in keeps to itself; the interval is never reached
+	const std::string config = R"({
+		"debug": true,
+		"metrics": { "interval_s": 3600 },
+		"mode": ")" + options.mode + R"(", "rate_hz": )" + std::to_string(options.rate_hz) + R"(,
+		"controllers": [
+			{ "name": "controller1", "type": "Move", "id": 0, "prediction_ms": 10, "filter": { "type": "one_euro" },
+				"stream": [ "position", "physics", "calibrated_sensor" ] },
+			{ "name": "navi", "type": "Navi", "id": 1 },
+			{ "name": "ds4", "type": "DualShock4", "id": 2 },
+			{ "name": "hmd", "type": "VirtualHMD", "id": 0 }
+		]
+	})";
+	osvrPluginEntryPoint_inf_osvr_move(stand_in::context());
+	if (stand_in::instantiate(DEVICE_NAME, config) != OSVR_RETURN_SUCCESS) {
+		for (const std::string& message : stand_in::log_messages())
+			std::fprintf(stderr, "%s\n", message.c_str());
+		return 1;
+	}
+
+	const uint64_t frames_before = stand_in::frames_delivered();
+	stand_in::start_devices();
+	std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+	stand_in::stop_devices();
+	const uint64_t frames = stand_in::frames_delivered() - frames_before;
+
+	std::printf("inf_osvr_move bench: %zu devices, %s mode at %g Hz, frames at %g Hz, %g s, %s lanes\n",
+		devices.size(), options.mode.c_str(), options.rate_hz, options.frame_rate_hz, options.seconds, POSE_BATCH_SSE ? "SSE" : "scalar");
+	std::printf("Service: %llu frames delivered, %llu polls\n", (unsigned long long)frames, (unsigned long long)poll_metrics.polls.value());
+	print_histogram("PSM update", poll_metrics.psm_update.snapshot());
+	for (const std::unique_ptr<DeviceGroup>& group : groups) {
+		const ReportMetrics& metrics = group->metrics;
+		const uint64_t ticks = metrics.ticks.value();
+		if (ticks == 0)
+			continue;
+		const Histogram::Snapshot interval = metrics.interval.snapshot();
+		std::printf("Group %s: %llu ticks (%.1f per second), %.2f OSVR calls per tick, %llu reports sent\n", group->name.c_str(),
+			(unsigned long long)ticks, ticks / options.seconds, (double)metrics.calls.value() / ticks, (unsigned long long)stand_in::report_count());
+		print_histogram("tick cost", metrics.tick_cost.snapshot());
+		print_histogram("convert", metrics.convert.snapshot());
+		print_histogram("send", metrics.send.snapshot());
+		print_histogram("interval", interval);
+		std::printf("  %-12s p99 - p50 %llu us, max - p50 %llu us\n", "jitter",
+			(unsigned long long)(interval.percentile(99) - interval.percentile(50)), (unsigned long long)(interval.percentile(100) - interval.percentile(50)));
+	}
+	for (const DeviceRecord& device : devices) {
+		const DeviceMetrics& metrics = device.feed->metrics;
+		std::printf("Device %s: %llu frames, %llu dropped, %llu repeats", device.name.c_str(), (unsigned long long)metrics.frames.value(),
+			(unsigned long long)metrics.dropped.value(), (unsigned long long)metrics.repeats.value());
+		if (device.imu)
+			std::printf(", %llu IMU samples, %llu lost", (unsigned long long)metrics.imu_samples.value(), (unsigned long long)metrics.imu_lost.value());
+		std::printf("\n");
+		if (device.type->tracked) {
+			print_histogram("latency", metrics.latency.snapshot());
+			print_histogram("frame age", metrics.age.snapshot());
+		}
+	}
+	const bool clean = stand_in::channel_errors() == 0;
+	if (!clean)
+		std::printf("%llu reports named a channel their interface doesn't have\n", (unsigned long long)stand_in::channel_errors());
+	stand_in::unload();
+
+	bench_pose_kernel(3, std::min(options.seconds, 1.0));
+	bench_pose_kernel(16, std::min(options.seconds, 1.0));
+	return clean ? 0 : 1;
+}
@@ -0,0 +1,1098 @@
+// Tests for inf_osvr_move.cpp, built against the stand-ins in stand_in/. The plugin is a single
+// translation unit with everything in an anonymous namespace, so it is included here whole: the
+// building blocks are tested directly, and the plugin as a whole through its OSVR entry point.
+#include "../inf_osvr_move.cpp"
+
+#include "stand_in.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <set>
+
+namespace {
+	struct TestCase {
+		const char* name;
+		void (*run)();
+	};
+	std::vector<TestCase>& test_cases() {
+		static std::vector<TestCase> cases;
+		return cases;
+	}
+	struct RegisterTest {
+		RegisterTest(const char* name, void (*run)()) {
+			test_cases().push_back({ name, run });
+		}
+	};
+	int failed_checks = 0;
+}
+
+#define TEST(name) \
+	static void name(); \
+	static RegisterTest name##_registration(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			failed_checks++; \
+		} \
+	} while (0)
+
+#define CHECK_NEAR(a, b, tolerance) \
+	do { \
+		const double check_a = (a), check_b = (b); \
+		if (!(std::abs(check_a - check_b) <= (tolerance))) { \
+			std::fprintf(stderr, "%s:%d: CHECK_NEAR(%s, %s) failed, %g vs %g\n", __FILE__, __LINE__, #a, #b, check_a, check_b); \
+			failed_checks++; \
+		} \
+	} while (0)
+
+namespace {
+	// Deterministic noise in [-1, 1]
+	class Noise {
+	public:
+		explicit Noise(uint32_t seed):state_(seed) {}
+		double next() {
+			state_ = state_ * 1664525u + 1013904223u;
+			return (state_ >> 8) / double(1 << 23) - 1.0;
+		}
+	private:
+		uint32_t state_;
+	};
+
+	struct Vec {
+		double x, y, z;
+	};
+	struct Quat {
+		double w, x, y, z;
+	};
+	Vec operator+(Vec a, Vec b) {
+		return { a.x + b.x, a.y + b.y, a.z + b.z };
+	}
+	Vec operator*(Vec a, double s) {
+		return { a.x * s, a.y * s, a.z * s };
+	}
+	Vec cross(Vec a, Vec b) {
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+	Quat operator*(Quat a, Quat b) {
+		return {
+			a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+			a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+			a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w
+		};
+	}
+	Vec rotate(Quat q, Vec v) {
+		const Quat r = q * Quat{ 0, v.x, v.y, v.z } * Quat{ q.w, -q.x, -q.y, -q.z };
+		return { r.x, r.y, r.z };
+	}
+	Quat normalized(Quat q) {
+		const double norm = std::sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+		return { q.w / norm, q.x / norm, q.y / norm, q.z / norm };
+	}
+
+	double now_seconds() {
+		OSVR_TimeValue now;
+		osvrTimeValueGetNow(&now);
+		return time_value_seconds(now);
+	}
+
+	template <typename Predicate>
+	bool wait_until(Predicate done, double seconds = 5.0) {
+		const clock::time_point deadline = clock::now() + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(seconds));
+		while (!done()) {
+			if (clock::now() > deadline)
+				return false;
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+		return true;
+	}
+
+	void run_for(double seconds) {
+		std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+	}
+
+	// Unloads whatever the last test loaded and puts the plugin's globals back to how a fresh load finds them
+	void reset_plugin() {
+		stand_in::reset();
+		devices.clear();
+		groups.clear();
+		frame_replayer.reset();
+		pose_export.reset();
+		room_alignment = RigidTransform();
+		metrics_enabled = false;
+		display_json = false;
+	}
+
+	OSVR_ReturnCode load_plugin(const std::string& config) {
+		osvrPluginEntryPoint_inf_osvr_move(stand_in::context());
+		return stand_in::instantiate(DEVICE_NAME, config);
+	}
+
+	std::vector<stand_in::Report> reports_of(stand_in::ReportKind kind, const std::string& device = DEVICE_NAME) {
+		std::vector<stand_in::Report> matching;
+		for (const stand_in::Report& report : stand_in::reports()) {
+			if (report.kind == kind && report.device == device)
+				matching.push_back(report);
+		}
+		return matching;
+	}
+
+	size_t count_poses(OSVR_ChannelCount sensor, const std::string& device = DEVICE_NAME) {
+		size_t count = 0;
+		for (const stand_in::Report& report : reports_of(stand_in::ReportKind::Pose, device))
+			count += report.channel == sensor;
+		return count;
+	}
+
+	Json::Value parse_json(const std::string& text) {
+		Json::Value value;
+		Json::Reader reader;
+		reader.parse(text, value);
+		return value;
+	}
+
+	std::string temp_path(const std::string& name) {
+		const char* dir = std::getenv("TMPDIR");
+		return std::string(dir ? dir : "/tmp") + "/inf_osvr_move_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "_" + name;
+	}
+}
+
+// Building blocks
+
+TEST(triple_buffer_hands_over_the_latest_value) {
+	TripleBuffer<int> buffer;
+	CHECK(buffer.front() == 0);
+	buffer.back() = 1;
+	buffer.publish();
+	buffer.back() = 2;
+	buffer.publish();
+	CHECK(buffer.front() == 2);
+	CHECK(buffer.front() == 2);
+	buffer.back() = 3;
+	buffer.publish();
+	CHECK(buffer.front() == 3);
+
+	// The consumer never sees a value go backwards or a half written one
+	struct Pair {
+		uint64_t value;
+		uint64_t check;
+	};
+	TripleBuffer<Pair> pairs;
+	std::atomic<bool> done{ false };
+	std::thread producer([&] {
+		for (uint64_t i = 1; i <= 200000; i++) {
+			pairs.back() = { i, ~i };
+			pairs.publish();
+		}
+		done = true;
+	});
+	uint64_t last = 0;
+	bool consistent = true, ordered = true;
+	while (!done) {
+		const Pair pair = pairs.front();
+		consistent &= pair.value == 0 || pair.check == ~pair.value;
+		ordered &= pair.value >= last;
+		last = pair.value;
+	}
+	producer.join();
+	CHECK(consistent);
+	CHECK(ordered);
+	CHECK(pairs.front().value == 200000);
+}
+
+TEST(imu_ring_keeps_order_and_drops_when_full) {
+	ImuRing ring;
+	ImuSample sample = {};
+	for (size_t i = 0; i < ImuRing::CAPACITY; i++) {
+		sample.time = (double)i;
+		CHECK(ring.push(sample));
+	}
+	CHECK(!ring.push(sample));
+	for (size_t i = 0; i < ImuRing::CAPACITY; i++) {
+		CHECK(ring.pop(sample));
+		CHECK(sample.time == (double)i);
+	}
+	CHECK(!ring.pop(sample));
+
+	// Across threads every sample comes out once, in order, as long as the consumer keeps up
+	std::unique_ptr<ImuRing> shared(new ImuRing());
+	const int count = 100000;
+	std::thread producer([&] {
+		ImuSample pushed = {};
+		for (int i = 1; i <= count; ) {
+			pushed.time = i;
+			if (shared->push(pushed))
+				i++;
+		}
+	});
+	int expected = 1;
+	bool ordered = true;
+	while (expected <= count) {
+		ImuSample popped;
+		if (!shared->pop(popped))
+			continue;
+		ordered &= popped.time == expected;
+		expected++;
+	}
+	producer.join();
+	CHECK(ordered);
+}
+
+TEST(histogram_percentiles_stay_within_a_bucket) {
+	Histogram histogram;
+	CHECK(histogram.snapshot().percentile(50) == 0);
+	for (int us = 0; us < 8; us++)
+		histogram.record(std::chrono::microseconds(us));
+	Histogram::Snapshot small = histogram.snapshot();
+	CHECK(small.count() == 8);
+	CHECK(small.percentile(100) == 7);
+	CHECK(small.percentile(50) == 3);
+
+	// Every value lands in a bucket whose upper bound is at most 12.5% above it
+	const uint64_t values[] = { 8, 9, 15, 16, 17, 100, 999, 1000, 1001, 12345, 999999, 5000000 };
+	for (uint64_t value : values) {
+		Histogram single;
+		single.record(std::chrono::microseconds(value));
+		const uint64_t bound = single.snapshot().percentile(50);
+		CHECK(bound >= value);
+		CHECK(bound <= value + value / 8);
+	}
+
+	// Snapshots subtract into the interval between them
+	Histogram::Snapshot before = histogram.snapshot();
+	for (int i = 0; i < 100; i++)
+		histogram.record(std::chrono::microseconds(1000));
+	Histogram::Snapshot interval = histogram.snapshot() - before;
+	CHECK(interval.count() == 100);
+	CHECK(interval.sum_us == 100000);
+	CHECK(interval.percentile(50) >= 1000 && interval.percentile(50) <= 1125);
+	CHECK(interval.to_json()["count"].asUInt64() == 100);
+}
+
+TEST(clock_mapper_follows_the_fastest_frame) {
+	ClockMapper mapper;
+	const double base = 1000.0;
+	// Frames sampled at 10ms steps on the service clock, arriving with 5ms of latency and some jitter
+	OSVR_TimeValue mapped = mapper.map(1.0, seconds_time_value(base + 1.0 + 0.008));
+	CHECK_NEAR(time_value_seconds(mapped), base + 1.008, 1e-6);
+	mapped = mapper.map(1.01, seconds_time_value(base + 1.01 + 0.005));
+	CHECK_NEAR(time_value_seconds(mapped), base + 1.015, 1e-6);
+	// A late frame is placed where the fastest offset says it was sampled, not when it arrived
+	mapped = mapper.map(1.02, seconds_time_value(base + 1.02 + 0.030));
+	CHECK(time_value_seconds(mapped) < base + 1.02 + 0.006);
+	// Without a service timestamp the receive time is all there is
+	mapped = mapper.map(0, seconds_time_value(base + 2.0));
+	CHECK_NEAR(time_value_seconds(mapped), base + 2.0, 1e-6);
+}
+
+TEST(pose_batch_matches_a_scalar_reference) {
+	// Enough entries for whole SIMD lanes and a scalar tail
+	const size_t count = 11;
+	const float scale = 0.01f;
+	RigidTransform alignment;
+	const float alignment_position[] = { 0.5f, -1.0f, 2.0f };
+	const Quat alignment_q = normalized({ 0.9, 0.1, -0.3, 0.2 });
+	std::copy(alignment_position, alignment_position + 3, alignment.position);
+	alignment.orientation[0] = (float)alignment_q.w; alignment.orientation[1] = (float)alignment_q.x;
+	alignment.orientation[2] = (float)alignment_q.y; alignment.orientation[3] = (float)alignment_q.z;
+
+	Noise noise(7);
+	PoseBatch batch;
+	batch.reserve(count);
+	std::vector<PSMPosef> poses(count);
+	std::vector<PSMPhysicsData> physics(count);
+	std::vector<RigidTransform> offsets(count);
+	for (size_t i = 0; i < count; i++) {
+		const Quat q = normalized({ noise.next(), noise.next(), noise.next(), noise.next() });
+		const Quat o = normalized({ 1 + noise.next(), noise.next(), noise.next(), noise.next() });
+		poses[i].Position = { (float)(100 * noise.next()), (float)(100 * noise.next()), (float)(100 * noise.next()) };
+		poses[i].Orientation = { (float)q.w, (float)q.x, (float)q.y, (float)q.z };
+		physics[i].LinearVelocityCmPerSec = { (float)(50 * noise.next()), (float)(50 * noise.next()), (float)(50 * noise.next()) };
+		physics[i].LinearAccelerationCmPerSecSqr = { (float)(50 * noise.next()), (float)(50 * noise.next()), (float)(50 * noise.next()) };
+		physics[i].AngularVelocityRadPerSec = { (float)noise.next(), (float)noise.next(), (float)noise.next() };
+		physics[i].AngularAccelerationRadPerSecSqr = { (float)noise.next(), (float)noise.next(), (float)noise.next() };
+		offsets[i].position[0] = (float)(0.1 * noise.next()); offsets[i].position[1] = (float)(0.1 * noise.next()); offsets[i].position[2] = (float)(0.1 * noise.next());
+		offsets[i].orientation[0] = (float)o.w; offsets[i].orientation[1] = (float)o.x; offsets[i].orientation[2] = (float)o.y; offsets[i].orientation[3] = (float)o.z;
+		batch.add(poses[i], physics[i], offsets[i]);
+	}
+	batch.transform(scale, alignment);
+
+	for (size_t i = 0; i < count; i++) {
+		const Quat q = { poses[i].Orientation.w, poses[i].Orientation.x, poses[i].Orientation.y, poses[i].Orientation.z };
+		const Quat offset_q = { offsets[i].orientation[0], offsets[i].orientation[1], offsets[i].orientation[2], offsets[i].orientation[3] };
+		const Vec lever = rotate(q, { offsets[i].position[0], offsets[i].position[1], offsets[i].position[2] });
+		const Vec w = { physics[i].AngularVelocityRadPerSec.x, physics[i].AngularVelocityRadPerSec.y, physics[i].AngularVelocityRadPerSec.z };
+		const Vec position = Vec{ poses[i].Position.x, poses[i].Position.y, poses[i].Position.z } * scale + lever;
+		const Vec velocity = Vec{ physics[i].LinearVelocityCmPerSec.x, physics[i].LinearVelocityCmPerSec.y, physics[i].LinearVelocityCmPerSec.z } * scale + cross(w, lever);
+		const Vec expected_p = rotate(alignment_q, position) + Vec{ alignment_position[0], alignment_position[1], alignment_position[2] };
+		const Vec expected_v = rotate(alignment_q, velocity);
+		const Vec expected_w = rotate(alignment_q, w);
+		const Quat expected_q = alignment_q * q * offset_q;
+
+		CHECK_NEAR(batch.get(PoseBatch::PX, i), expected_p.x, 1e-4);
+		CHECK_NEAR(batch.get(PoseBatch::PY, i), expected_p.y, 1e-4);
+		CHECK_NEAR(batch.get(PoseBatch::PZ, i), expected_p.z, 1e-4);
+		CHECK_NEAR(batch.get(PoseBatch::QW, i), expected_q.w, 1e-5);
+		CHECK_NEAR(batch.get(PoseBatch::QX, i), expected_q.x, 1e-5);
+		CHECK_NEAR(batch.get(PoseBatch::QY, i), expected_q.y, 1e-5);
+		CHECK_NEAR(batch.get(PoseBatch::QZ, i), expected_q.z, 1e-5);
+		CHECK_NEAR(batch.get(PoseBatch::VX, i), expected_v.x, 1e-4);
+		CHECK_NEAR(batch.get(PoseBatch::VY, i), expected_v.y, 1e-4);
+		CHECK_NEAR(batch.get(PoseBatch::VZ, i), expected_v.z, 1e-4);
+		CHECK_NEAR(batch.get(PoseBatch::WX, i), expected_w.x, 1e-5);
+		CHECK_NEAR(batch.get(PoseBatch::WY, i), expected_w.y, 1e-5);
+		CHECK_NEAR(batch.get(PoseBatch::WZ, i), expected_w.z, 1e-5);
+	}
+}
+
+namespace {
+	// Runs positions through a one-tracker filter bank at 100Hz, returns the filtered x values
+	std::vector<float> filter_positions(PoseFilterBank& filters, const std::vector<float>& xs, double start) {
+		PoseBatch batch;
+		batch.reserve(1);
+		std::vector<float> filtered;
+		for (size_t i = 0; i < xs.size(); i++) {
+			PSMPosef pose = {};
+			pose.Position.x = xs[i];
+			pose.Orientation.w = 1;
+			batch.clear();
+			batch.add(pose, PSMPhysicsData(), RigidTransform());
+			const OSVR_TimeValue captured = seconds_time_value(start + i * 0.01);
+			const std::vector<TrackerReport> reports = { { 0, captured, false, 0.0, captured } };
+			filters.apply(batch, reports);
+			filtered.push_back(batch.get(PoseBatch::PX, 0));
+		}
+		return filtered;
+	}
+
+	double spread(const std::vector<float>& values, size_t from) {
+		double mean = 0, sum = 0;
+		for (size_t i = from; i < values.size(); i++)
+			mean += values[i];
+		mean /= values.size() - from;
+		for (size_t i = from; i < values.size(); i++)
+			sum += (values[i] - mean) * (values[i] - mean);
+		return std::sqrt(sum / (values.size() - from));
+	}
+}
+
+TEST(filters_smooth_jitter_and_follow_motion) {
+	for (FilterType type : { FilterType::OneEuro, FilterType::Adaptive }) {
+		FilterSettings settings;
+		settings.type = type;
+		PoseFilterBank filters;
+		filters.configure(0, settings);
+
+		Noise noise(11);
+		std::vector<float> still(300);
+		for (float& x : still)
+			x = (float)(0.005 * noise.next());
+		const std::vector<float> filtered = filter_positions(filters, still, 100.0);
+		CHECK(filtered[0] == still[0]);
+		CHECK(spread(filtered, 50) < spread(still, 50) / 3);
+
+		// A step is followed within a second
+		const std::vector<float> step(100, 0.5f);
+		const std::vector<float> moved = filter_positions(filters, step, 103.0);
+		CHECK(moved.back() > 0.48f);
+
+		// After a gap the filter starts over from the new pose
+		const std::vector<float> after_gap = filter_positions(filters, { 2.0f }, 105.0);
+		CHECK(after_gap[0] == 2.0f);
+	}
+
+	// Devices without a filter pass straight through
+	PoseFilterBank filters;
+	filters.configure(0, FilterSettings());
+	const std::vector<float> raw = { 0.1f, 0.7f, -0.3f };
+	CHECK(filter_positions(filters, raw, 200.0) == raw);
+}
+
+TEST(activity_gate_holds_back_still_devices) {
+	IdleSettings settings;
+	settings.enabled = true;
+	settings.after_ms = 100;
+	settings.keepalive_hz = 10;
+	ActivityGate gate;
+	gate.configure(0, settings);
+
+	PSMPosef pose = {};
+	pose.Orientation.w = 1;
+	const clock::time_point start = clock::now();
+	auto at = [start](int ms) { return start + std::chrono::milliseconds(ms); };
+
+	// Active for after_ms, then only every keep-alive period
+	int admitted = 0;
+	for (int ms = 0; ms < 1100; ms += 10)
+		admitted += gate.admit(0, pose, false, at(ms));
+	CHECK(admitted >= 10 + 9 && admitted <= 10 + 11);
+
+	// Moving more than the threshold, or an input change, wakes it at once
+	pose.Position.x += 1.0f;
+	CHECK(gate.admit(0, pose, false, at(1105)));
+	CHECK(gate.admit(0, pose, false, at(1115)));
+	CHECK(gate.admit(0, pose, false, at(1300)));
+	CHECK(!gate.admit(0, pose, false, at(1310)));
+	CHECK(gate.admit(0, pose, true, at(1320)));
+}
+
+TEST(shared_memory_readers_never_see_a_torn_slot) {
+#ifndef _WIN32
+	const std::string name = "inf_osvr_move_test_" + std::to_string(getpid());
+	PoseExport writer;
+	std::string error;
+	CHECK(writer.open(name, 1, error));
+	writer.set_path(0, "/inf_osvr_move/MoveDevice/semantic/controller1");
+
+	// Read it through a mapping of its own, like another process would
+	const int fd = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+	CHECK(fd >= 0);
+	const size_t size = sizeof(ExportHeader) + sizeof(ExportSlot);
+	void* view = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	CHECK(view != MAP_FAILED);
+	const ExportHeader* header = static_cast<const ExportHeader*>(view);
+	CHECK(std::equal(std::begin(EXPORT_MAGIC), std::end(EXPORT_MAGIC), header->magic));
+	CHECK(header->slot_count == 1 && header->slot_size == sizeof(ExportSlot));
+	const ExportSlot* shared = reinterpret_cast<const ExportSlot*>(static_cast<const char*>(view) + header->header_size);
+	CHECK(std::string(shared->path) == "/inf_osvr_move/MoveDevice/semantic/controller1");
+
+	std::atomic<bool> done{ false };
+	std::thread producer([&] {
+		for (uint64_t i = 1; i <= 200000; i++) {
+			ExportSlot& slot = writer.begin_write(0);
+			slot.frames = i;
+			slot.sample_time = (double)i;
+			for (double& value : slot.position)
+				value = (double)i;
+			writer.end_write(slot);
+		}
+		done = true;
+	});
+	uint64_t reads = 0, torn = 0, last = 0;
+	bool ordered = true;
+	while (!done) {
+		alignas(ExportSlot) char copy[sizeof(ExportSlot)];
+		const uint32_t before = shared->sequence.load(std::memory_order_acquire);
+		if (before & 1)
+			continue;
+		std::memcpy(copy, shared, sizeof(copy));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (shared->sequence.load(std::memory_order_relaxed) != before)
+			continue;
+		const ExportSlot& slot = *reinterpret_cast<const ExportSlot*>(copy);
+		reads++;
+		torn += slot.sample_time != (double)slot.frames || slot.position[0] != (double)slot.frames || slot.position[2] != (double)slot.frames;
+		ordered &= slot.frames >= last;
+		last = slot.frames;
+	}
+	producer.join();
+	munmap(view, size);
+	CHECK(reads > 0);
+	CHECK(torn == 0);
+	CHECK(ordered);
+#endif
+}
+
+TEST(recordings_load_and_reject_damage) {
+	const std::string path = temp_path("frames.rec");
+	{
+		FrameRecorder recorder;
+		CHECK(recorder.open(path));
+		PSMController controller = {};
+		controller.ControllerType = PSMController_Move;
+		PSMHeadMountedDisplay hmd = {};
+		hmd.HmdType = PSMHmd_Virtual;
+		for (int i = 1; i <= 5; i++) {
+			controller.OutputSequenceNum = i;
+			controller.ControllerState.PSMoveState.Pose.Position.x = (float)i;
+			recorder.write(false, 0, true, seconds_time_value(10.0 + i * 0.01), &controller, sizeof(controller));
+			hmd.OutputSequenceNum = i;
+			recorder.write(true, 1, true, seconds_time_value(10.0 + i * 0.01), &hmd, sizeof(hmd));
+		}
+		recorder.write(false, 0, false, seconds_time_value(10.1), nullptr, 0);
+	}
+
+	FrameReplayer replayer;
+	std::string error;
+	CHECK(replayer.load(path, false, error));
+	PSMControllerList controllers;
+	PSMHmdList hmds;
+	replayer.device_lists(controllers, hmds);
+	CHECK(controllers.count == 1 && controllers.controller_id[0] == 0 && controllers.controller_type[0] == PSMController_Move);
+	CHECK(hmds.count == 1 && hmds.hmd_id[0] == 1 && hmds.hmd_type[0] == PSMHmd_Virtual);
+	CHECK(replayer.controller(0)->OutputSequenceNum == 1);
+	CHECK(replayer.controller(1) == nullptr);
+
+	// As fast as possible applies one record per step, in order
+	int steps = 0;
+	int last_sequence = 0;
+	bool ordered = true;
+	while (!replayer.finished()) {
+		CHECK(replayer.advance(clock::now()));
+		steps++;
+		const int sequence = replayer.controller(0)->OutputSequenceNum;
+		ordered &= sequence >= last_sequence;
+		last_sequence = sequence;
+	}
+	CHECK(steps == 11);
+	CHECK(ordered);
+	CHECK(last_sequence == 5);
+	CHECK(replayer.controller(0)->ControllerState.PSMoveState.Pose.Position.x == 5.0f);
+	CHECK(!replayer.connected(false, 0));
+	CHECK(replayer.connected(true, 1));
+
+	std::vector<char> bytes;
+	{
+		std::ifstream file(path, std::ios::binary);
+		bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	auto load_bytes = [&path](const std::vector<char>& data, std::string& load_error) {
+		std::ofstream(path, std::ios::binary | std::ios::trunc).write(data.data(), data.size());
+		FrameReplayer damaged;
+		return damaged.load(path, true, load_error);
+	};
+
+	std::vector<char> truncated(bytes.begin(), bytes.end() - 30);
+	CHECK(!load_bytes(truncated, error));
+	CHECK(error == "it is truncated");
+
+	std::vector<char> wrong_magic = bytes;
+	wrong_magic[0] = 'X';
+	CHECK(!load_bytes(wrong_magic, error));
+	CHECK(error.find("not a recording") != std::string::npos);
+
+	std::vector<char> other_client = bytes;
+	RecordingHeader header;
+	std::memcpy(&header, other_client.data(), sizeof(header));
+	header.controller_size += 8;
+	std::memcpy(other_client.data(), &header, sizeof(header));
+	CHECK(!load_bytes(other_client, error));
+	CHECK(error.find("different PSMoveService client") != std::string::npos);
+
+	std::remove(path.c_str());
+	CHECK(!replayer.load(path, true, error));
+	CHECK(error == "could not open it");
+}
+
+TEST(config_parsers_reject_invalid_entries) {
+	unsigned int flags = 0;
+	std::string unknown;
+	CHECK(parse_stream_flags(parse_json("[\"position\", \"calibrated_sensor\"]"), flags, unknown));
+	CHECK(flags == (PSMStreamFlags_includePositionData | PSMStreamFlags_includeCalibratedSensorData));
+	CHECK(!parse_stream_flags(parse_json("[\"position\", \"bogus\"]"), flags, unknown));
+	CHECK(unknown == "bogus");
+
+	RigidTransform transform;
+	CHECK(parse_transform(parse_json("{\"position\": [1, 2, 3], \"orientation\": [2, 0, 0, 0]}"), transform));
+	CHECK(transform.position[2] == 3.0f && transform.orientation[0] == 1.0f);
+	CHECK(!parse_transform(parse_json("{\"position\": [1, 2]}"), transform));
+	CHECK(!parse_transform(parse_json("{\"orientation\": [0, 0, 0, 0]}"), transform));
+
+	FilterSettings filter;
+	CHECK(parse_filter(parse_json("{\"type\": \"adaptive\", \"max_cutoff_hz\": 30}"), filter));
+	CHECK(filter.type == FilterType::Adaptive && filter.max_cutoff_hz == 30);
+	CHECK(!parse_filter(parse_json("{\"type\": \"kalman\"}"), filter));
+	CHECK(!parse_filter(parse_json("{\"type\": \"one_euro\", \"min_cutoff_hz\": 0}"), filter));
+
+	IdleSettings idle;
+	CHECK(parse_idle(parse_json("{\"after_ms\": 250}"), idle));
+	CHECK(idle.enabled && idle.after_ms == 250);
+	CHECK(!parse_idle(parse_json("{\"keepalive_hz\": 0}"), idle));
+}
+
+// The plugin as a whole, through its entry point and the stand-ins
+
+TEST(reports_every_device_type) {
+	reset_plugin();
+	stand_in::connect_controller(0, PSMController_Move);
+	stand_in::connect_controller(1, PSMController_Navi);
+	stand_in::connect_controller(2, PSMController_DualShock4);
+	stand_in::connect_controller(3, PSMController_Virtual);
+	stand_in::connect_hmd(0, PSMHmd_Virtual);
+	stand_in::connect_hmd(1, PSMHmd_Morpheus);
+	const double start = now_seconds();
+	CHECK(load_plugin(R"({
+		"mode": "event", "rate_hz": 200,
+		"controllers": [
+			{ "name": "controller1", "type": "Move", "id": 0 },
+			{ "name": "navi", "type": "Navi", "id": 1 },
+			{ "name": "ds4", "type": "DualShock4", "id": 2 },
+			{ "name": "virtual", "type": "VirtualMove", "id": 3 },
+			{ "name": "hmd", "type": "VirtualHMD", "id": 0 },
+			{ "name": "psvr", "type": "PSVR", "id": 1 }
+		]
+	})") == OSVR_RETURN_SUCCESS);
+
+	const Json::Value descriptor = parse_json(stand_in::descriptor(DEVICE_NAME));
+	const Json::Value& semantic = descriptor["semantic"];
+	for (const char* path : { "controller1/tracker", "controller1/cross", "controller1/trigger", "navi/stickx", "ds4/tracker",
+		"ds4/rtrigger", "virtual/tracker", "hmd/tracker", "psvr/tracker" })
+		CHECK(semantic.isMember(path));
+	CHECK(!semantic.isMember("navi/tracker"));
+	CHECK(descriptor["interfaces"]["button"]["count"].asUInt() == 9 + 11 + 18);
+	CHECK(descriptor["interfaces"]["analog"]["count"].asUInt() == 1 + 3 + 6);
+
+	stand_in::start_devices();
+	CHECK(wait_until([] {
+		for (OSVR_ChannelCount sensor = 0; sensor < 5; sensor++) {
+			if (count_poses(sensor) < 10)
+				return false;
+		}
+		return true;
+	}));
+	stand_in::stop_devices();
+	const double end = now_seconds();
+
+	CHECK(stand_in::channel_errors() == 0);
+	bool units = true, timestamps = true;
+	for (const stand_in::Report& pose : reports_of(stand_in::ReportKind::Pose)) {
+		// The synthetic service moves within 30cm of (0, 1.2m, 0) in centimeters, reported in meters
+		const double norm = std::sqrt(pose.values[3] * pose.values[3] + pose.values[4] * pose.values[4] + pose.values[5] * pose.values[5] + pose.values[6] * pose.values[6]);
+		units &= std::abs(norm - 1) < 1e-4 && std::abs(pose.values[0]) < 0.3 && std::abs(pose.values[1] - 1.2) < 0.3;
+		timestamps &= pose.time > start - 1 && pose.time < end + 1;
+	}
+	CHECK(units);
+	CHECK(timestamps);
+	CHECK(!reports_of(stand_in::ReportKind::Velocity).empty());
+	CHECK(!reports_of(stand_in::ReportKind::Buttons).empty());
+	CHECK(!reports_of(stand_in::ReportKind::Analogs).empty());
+	reset_plugin();
+}
+
+TEST(buttons_and_analogs_are_only_sent_when_they_change) {
+	reset_plugin();
+	stand_in::connect_controller(0, PSMController_Move);
+	stand_in::set_motion(false);
+	CHECK(load_plugin(R"({ "mode": "event", "controllers": [ { "name": "controller1", "type": "Move", "id": 0 } ] })") == OSVR_RETURN_SUCCESS);
+	stand_in::start_devices();
+	CHECK(wait_until([] { return count_poses(0) >= 5; }));
+	stand_in::clear_reports();
+
+	run_for(0.3);
+	CHECK(count_poses(0) > 10);
+	CHECK(reports_of(stand_in::ReportKind::Buttons).empty());
+	CHECK(reports_of(stand_in::ReportKind::Analogs).empty());
+
+	stand_in::edit_controller(0, [](PSMController& controller) { controller.ControllerState.PSMoveState.TriangleButton = PSMButtonState_DOWN; });
+	CHECK(wait_until([] { return !reports_of(stand_in::ReportKind::Buttons).empty(); }));
+	run_for(0.1);
+	stand_in::stop_devices();
+	const std::vector<stand_in::Report> buttons = reports_of(stand_in::ReportKind::Buttons);
+	CHECK(buttons.size() == 1);
+	CHECK(buttons[0].values.size() == 9 && buttons[0].values[0] == OSVR_BUTTON_PRESSED && buttons[0].values[2] == OSVR_BUTTON_NOT_PRESSED);
+	reset_plugin();
+}
+
+TEST(predictions_start_from_the_filtered_pose) {
+	reset_plugin();
+	stand_in::connect_controller(0, PSMController_Move);
+	stand_in::set_motion(false);
+	CHECK(load_plugin(R"({
+		"mode": "event",
+		"controllers": [ { "name": "controller1", "type": "Move", "id": 0, "prediction_ms": 100, "filter": { "type": "one_euro" } } ]
+	})") == OSVR_RETURN_SUCCESS);
+	stand_in::start_devices();
+	CHECK(wait_until([] { return count_poses(0) >= 20; }));
+	const double still_x = reports_of(stand_in::ReportKind::Pose).back().values[0];
+
+	// A sudden 1 m/s should move the very next pose 10cm ahead, not a smoothed fraction of that
+	stand_in::edit_controller(0, [](PSMController& controller) { controller.ControllerState.PSMoveState.PhysicsData.LinearVelocityCmPerSec.x = 100; });
+	CHECK(wait_until([] {
+		for (const stand_in::Report& velocity : reports_of(stand_in::ReportKind::Velocity)) {
+			if (velocity.values[0] > 0.5)
+				return true;
+		}
+		return false;
+	}));
+	stand_in::stop_devices();
+
+	const std::vector<stand_in::Report> reports = stand_in::reports();
+	size_t first = reports.size();
+	for (size_t i = 0; i < reports.size() && first == reports.size(); i++) {
+		if (reports[i].kind == stand_in::ReportKind::Velocity && reports[i].values[0] > 0.5)
+			first = i;
+	}
+	bool found = false;
+	for (size_t i = first; i-- > 0 && !found;) {
+		if (reports[i].kind == stand_in::ReportKind::Pose && reports[i].time == reports[first].time) {
+			CHECK_NEAR(reports[i].values[0], still_x + 0.1, 0.005);
+			found = true;
+		}
+	}
+	CHECK(found);
+	reset_plugin();
+}
+
+TEST(predicted_reports_carry_the_time_they_predict) {
+	reset_plugin();
+	stand_in::connect_controller(0, PSMController_Move);
+	stand_in::connect_controller(1, PSMController_Move);
+	CHECK(load_plugin(R"({
+		"mode": "event",
+		"controllers": [
+			{ "name": "predicted", "type": "Move", "id": 0, "prediction_ms": 100 },
+			{ "name": "measured", "type": "Move", "id": 1 }
+		]
+	})") == OSVR_RETURN_SUCCESS);
+	stand_in::start_devices();
+	CHECK(wait_until([] { return count_poses(0) >= 20 && count_poses(1) >= 20; }));
+	stand_in::stop_devices();
+
+	// Both devices deliver their frames together, so their newest reports were sampled together
+	double newest[2] = { 0, 0 }, newest_velocity[2] = { 0, 0 };
+	for (const stand_in::Report& report : stand_in::reports()) {
+		if (report.kind == stand_in::ReportKind::Pose && report.channel < 2)
+			newest[report.channel] = std::max(newest[report.channel], report.time);
+		if (report.kind == stand_in::ReportKind::Velocity && report.channel < 2)
+			newest_velocity[report.channel] = std::max(newest_velocity[report.channel], report.time);
+	}
+	CHECK_NEAR(newest[0] - newest[1], 0.1, 0.02);
+	CHECK_NEAR(newest_velocity[0] - newest_velocity[1], 0.1, 0.02);
+	reset_plugin();
+}
+
+TEST(devices_attach_as_they_connect_and_survive_a_service_restart) {
+	reset_plugin();
+	stand_in::connect_controller(0, PSMController_Move);
+	CHECK(load_plugin(R"({
+		"mode": "event",
+		"controllers": [
+			{ "name": "controller1", "type": "Move", "id": 0 },
+			{ "name": "controller2", "type": "Move", "id": 1 }
+		]
+	})") == OSVR_RETURN_SUCCESS);
+	CHECK(stand_in::logged("\"controller2\" is not connected"));
+	stand_in::start_devices();
+	CHECK(wait_until([] { return count_poses(0) >= 5; }));
+	CHECK(count_poses(1) == 0);
+
+	stand_in::connect_controller(1, PSMController_Move);
+	CHECK(wait_until([] { return count_poses(1) >= 5; }));
+	CHECK(stand_in::logged("\"controller2\" connected, attaching it"));
+
+	stand_in::disconnect_controller(1);
+	CHECK(wait_until([] { return stand_in::logged("\"controller2\" disconnected, detaching it"); }));
+
+	stand_in::set_service_up(false);
+	CHECK(wait_until([] { return stand_in::logged("Lost PSMoveService"); }));
+	stand_in::clear_reports();
+	stand_in::set_service_up(true);
+	CHECK(wait_until([] { return stand_in::logged("Reconnected to PSMoveService"); }));
+	CHECK(wait_until([] { return count_poses(0) >= 5; }));
+	stand_in::stop_devices();
+	CHECK(stand_in::channel_errors() == 0);
+	reset_plugin();
+}
+
+TEST(failed_stream_starts_are_retried) {
+	reset_plugin();
+	stand_in::connect_controller(0, PSMController_Move);
+	stand_in::set_stream_start(stand_in::StreamStart::Fail);
+	CHECK(load_plugin(R"({
+		"mode": "event",
+		"controllers": [
+			{ "name": "refused", "type": "Move", "id": 0 },
+			{ "name": "ignored", "type": "Move", "id": 1 },
+			{ "name": "navi_slot", "type": "Navi", "id": 2 }
+		]
+	})") == OSVR_RETURN_SUCCESS);
+	CHECK(stand_in::logged("Failed to start the data stream for \"refused\""));
+	stand_in::start_devices();
+
+	// A start PSMoveService never answers times out, and a device of the wrong type stays detached
+	stand_in::set_stream_start(stand_in::StreamStart::Ignore);
+	stand_in::connect_controller(1, PSMController_Move);
+	stand_in::connect_controller(2, PSMController_Move);
+	CHECK(wait_until([] { return stand_in::logged("Failed to start the data stream for \"ignored\""); }));
+	CHECK(wait_until([] { return stand_in::logged("\"navi_slot\" connected, but it is not a Navigation controller"); }));
+	// Neither streams, each attach only publishes the state PSMoveService had
+	CHECK(count_poses(0) < 5 && count_poses(1) < 5);
+
+	// Both are attached again on a later device list check, once their streams start
+	stand_in::set_stream_start(stand_in::StreamStart::Succeed);
+	CHECK(wait_until([] { return count_poses(0) >= 5 && count_poses(1) >= 5; }));
+	stand_in::stop_devices();
+	CHECK(!stand_in::logged("Lost PSMoveService"));
+	reset_plugin();
+}
+
+TEST(groups_report_through_their_own_devices) {
+	reset_plugin();
+	stand_in::connect_controller(0, PSMController_Move);
+	stand_in::connect_controller(1, PSMController_Navi);
+	stand_in::connect_hmd(0, PSMHmd_Virtual);
+	CHECK(load_plugin(R"({
+		"mode": "fixed", "rate_hz": 100,
+		"groups": { "Head": { "mode": "event", "rate_hz": 500 } },
+		"controllers": [
+			{ "name": "controller1", "type": "Move", "id": 0 },
+			{ "name": "navi", "type": "Navi", "id": 1 },
+			{ "name": "hmd", "type": "VirtualHMD", "id": 0, "group": "Head" }
+		]
+	})") == OSVR_RETURN_SUCCESS);
+	const std::vector<std::string> names = stand_in::device_names();
+	CHECK(names.size() == 2);
+	CHECK(parse_json(stand_in::descriptor("Head"))["semantic"]["hmd/tracker"].asString() == "tracker/0");
+	CHECK(parse_json(stand_in::descriptor(DEVICE_NAME))["semantic"]["controller1/tracker"].asString() == "tracker/0");
+	CHECK(!parse_json(stand_in::descriptor(DEVICE_NAME))["semantic"].isMember("hmd/tracker"));
+
+	stand_in::start_devices();
+	CHECK(wait_until([] { return count_poses(0, "Head") >= 10 && count_poses(0) >= 10; }));
+	stand_in::stop_devices();
+	CHECK(count_poses(1) == 0 && count_poses(1, "Head") == 0);
+	CHECK(reports_of(stand_in::ReportKind::Buttons, "Head").empty());
+	reset_plugin();
+}
+
+TEST(groups_only_wake_for_their_own_frames) {
+	reset_plugin();
+	stand_in::connect_controller(0, PSMController_Move);
+	CHECK(load_plugin(R"({
+		"debug": true, "metrics": { "interval_s": 3600 },
+		"mode": "event", "rate_hz": 1000,
+		"groups": { "Head": { "rate_hz": 2 } },
+		"controllers": [
+			{ "name": "controller1", "type": "Move", "id": 0 },
+			{ "name": "hmd", "type": "VirtualHMD", "id": 0, "group": "Head" }
+		]
+	})") == OSVR_RETURN_SUCCESS);
+	stand_in::start_devices();
+	run_for(1.0);
+	stand_in::stop_devices();
+	// The controller's frames wake its own group every time, the HMD's group only ticks at its deadline
+	CHECK(groups[0]->metrics.ticks.value() > 60);
+	CHECK(groups[1]->metrics.ticks.value() <= 4);
+	reset_plugin();
+}
+
+TEST(metrics_reports_add_up_to_the_totals) {
+	reset_plugin();
+	const std::string path = temp_path("metrics.jsonl");
+	stand_in::connect_controller(0, PSMController_Move);
+	CHECK(load_plugin(R"({
+		"debug": true, "metrics": { "interval_s": 0.1, "file": ")" + path + R"(" },
+		"mode": "event",
+		"controllers": [ { "name": "metered", "type": "Move", "id": 0 } ]
+	})") == OSVR_RETURN_SUCCESS);
+	stand_in::start_devices();
+	run_for(1.0);
+	stand_in::stop_devices();
+	CHECK(wait_until([] { return stand_in::logged("Metrics for the last"); }));
+	const uint64_t frames = devices[0].feed->metrics.frames.value();
+	const uint64_t ticks = groups[0]->metrics.ticks.value();
+	// Unloading writes a snapshot the poll thread hadn't got to yet
+	reset_plugin();
+
+	std::ifstream file(path);
+	std::string line;
+	size_t lines = 0;
+	uint64_t reported_frames = 0, reported_ticks = 0;
+	while (std::getline(file, line)) {
+		const Json::Value report = parse_json(line);
+		reported_frames += report["devices"]["metered"]["frames"].asUInt64();
+		reported_ticks += report["groups"][DEVICE_NAME]["ticks"].asUInt64();
+		lines++;
+	}
+	CHECK(lines >= 5);
+	CHECK(reported_frames > 0 && reported_frames <= frames);
+	CHECK(reported_ticks > 0 && reported_ticks <= ticks);
+	file.close();
+	std::remove(path.c_str());
+}
+
+TEST(imu_samples_are_all_reported_in_order) {
+	reset_plugin();
+	stand_in::connect_controller(0, PSMController_Move);
+	stand_in::set_frame_rate(500);
+	CHECK(load_plugin(R"({
+		"mode": "fixed", "rate_hz": 60,
+		"controllers": [ { "name": "controller1", "type": "Move", "id": 0, "stream": [ "position", "physics", "calibrated_sensor" ] } ]
+	})") == OSVR_RETURN_SUCCESS);
+	const Json::Value semantic = parse_json(stand_in::descriptor("controller1_imu"))["semantic"];
+	CHECK(semantic["imu/accelx"].asString() == "analog/0");
+	CHECK(semantic["imu/gyroz"].asString() == "analog/5");
+	CHECK(!parse_json(stand_in::descriptor(DEVICE_NAME))["semantic"].isMember("controller1/imu/accelx"));
+
+	stand_in::start_devices();
+	run_for(0.5);
+	stand_in::stop_devices();
+
+	// Each sample is one report of all six channels. The synthetic accelerometer x counts frames,
+	// so consecutive samples differ by exactly one.
+	const std::vector<stand_in::Report> samples = reports_of(stand_in::ReportKind::Analogs, "controller1_imu");
+	CHECK(samples.size() > 100);
+	bool whole = true, consecutive = true, in_time = true;
+	for (size_t i = 0; i < samples.size(); i++) {
+		whole &= samples[i].channel == IMU_CHANNELS && samples[i].values.size() == IMU_CHANNELS;
+		if (i > 0) {
+			consecutive &= samples[i].values[0] == samples[i - 1].values[0] + 1;
+			in_time &= samples[i].time >= samples[i - 1].time;
+		}
+	}
+	CHECK(whole);
+	CHECK(consecutive);
+	CHECK(in_time);
+	CHECK(devices[0].feed->metrics.imu_lost.value() == 0);
+	CHECK(reports_of(stand_in::ReportKind::Analog, "controller1_imu").empty());
+	CHECK(reports_of(stand_in::ReportKind::Analog).empty());
+	CHECK(stand_in::channel_errors() == 0);
+	reset_plugin();
+}
+
+TEST(idle_devices_drop_to_the_keepalive_rate) {
+	reset_plugin();
+	stand_in::connect_controller(0, PSMController_Move);
+	stand_in::set_motion(false);
+	CHECK(load_plugin(R"({
+		"mode": "event",
+		"idle": { "after_ms": 200, "keepalive_hz": 5 },
+		"controllers": [ { "name": "controller1", "type": "Move", "id": 0 } ]
+	})") == OSVR_RETURN_SUCCESS);
+	stand_in::start_devices();
+	run_for(0.4);
+	stand_in::clear_reports();
+	run_for(1.0);
+	const size_t idle_poses = count_poses(0);
+	CHECK(idle_poses >= 3 && idle_poses <= 7);
+
+	stand_in::set_motion(true);
+	stand_in::clear_reports();
+	run_for(0.5);
+	stand_in::stop_devices();
+	CHECK(count_poses(0) > 30);
+	CHECK(devices[0].feed->metrics.idle.value() > 0);
+	reset_plugin();
+}
+
+TEST(shared_memory_export_follows_the_reports) {
+#ifndef _WIN32
+	reset_plugin();
+	stand_in::connect_controller(0, PSMController_Move);
+	const std::string name = "inf_osvr_move_export_" + std::to_string(getpid());
+	CHECK(load_plugin(R"({ "mode": "event", "shared_memory": { "name": ")" + name + R"(" },
+		"controllers": [ { "name": "controller1", "type": "Move", "id": 0 } ] })") == OSVR_RETURN_SUCCESS);
+	stand_in::start_devices();
+	CHECK(wait_until([] { return count_poses(0) >= 20; }));
+	stand_in::stop_devices();
+
+	const int fd = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+	CHECK(fd >= 0);
+	const size_t size = sizeof(ExportHeader) + sizeof(ExportSlot);
+	void* view = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	CHECK(view != MAP_FAILED);
+	const ExportSlot& slot = *reinterpret_cast<const ExportSlot*>(static_cast<const char*>(view) + sizeof(ExportHeader));
+	CHECK(std::string(slot.path) == "/inf_osvr_move/MoveDevice/semantic/controller1");
+	CHECK(slot.sequence.load() % 2 == 0);
+	CHECK(slot.frames == count_poses(0));
+	CHECK((slot.flags & (EXPORT_CONNECTED | EXPORT_TRACKED | EXPORT_PHYSICS)) == (EXPORT_CONNECTED | EXPORT_TRACKED | EXPORT_PHYSICS));
+	const stand_in::Report last = reports_of(stand_in::ReportKind::Pose).back();
+	CHECK(slot.position[0] == last.values[0] && slot.orientation[0] == last.values[3]);
+	munmap(view, size);
+	reset_plugin();
+#endif
+}
+
+namespace {
+	// How many distinct frames of a device a recording holds
+	size_t recorded_frames(const std::string& path, bool hmd, int id) {
+		FrameReplayer replayer;
+		std::string error;
+		if (!replayer.load(path, false, error))
+			return 0;
+		std::set<int> sequences;
+		do {
+			if (replayer.connected(hmd, id))
+				sequences.insert(hmd ? replayer.hmd(id)->OutputSequenceNum : replayer.controller(id)->OutputSequenceNum);
+		} while (replayer.advance(clock::now()));
+		return sequences.size();
+	}
+}
+
+TEST(recorded_frames_replay_without_the_service) {
+	reset_plugin();
+	const std::string path = temp_path("session.rec");
+	stand_in::connect_controller(0, PSMController_Move);
+	stand_in::connect_hmd(0, PSMHmd_Virtual);
+	const std::string devices_config = R"("controllers": [
+		{ "name": "controller1", "type": "Move", "id": 0 },
+		{ "name": "hmd", "type": "VirtualHMD", "id": 0 }
+	])";
+	CHECK(load_plugin(R"({ "mode": "event", "record": { "file": ")" + path + R"(" }, )" + devices_config + "}") == OSVR_RETURN_SUCCESS);
+	stand_in::start_devices();
+	CHECK(wait_until([] { return count_poses(0) >= 30 && count_poses(1) >= 30; }));
+	reset_plugin();
+
+	// Nothing is connected any more, the recording stands in for the service
+	CHECK(load_plugin(R"({ "mode": "event", "replay": { "file": ")" + path + R"(", "speed": "realtime" }, )" + devices_config + "}") == OSVR_RETURN_SUCCESS);
+	stand_in::start_devices();
+	CHECK(wait_until([] { return stand_in::logged("Replay finished"); }));
+	stand_in::stop_devices();
+	CHECK(count_poses(0) >= 20);
+	CHECK(count_poses(1) >= 20);
+	CHECK(stand_in::service_updates() == 0);
+	reset_plugin();
+
+	// As fast as possible, but still every recorded frame is reported, once
+	const size_t controller_frames = recorded_frames(path, false, 0), hmd_frames = recorded_frames(path, true, 0);
+	CHECK(controller_frames >= 30 && hmd_frames >= 30);
+	CHECK(load_plugin(R"({ "mode": "event", "replay": { "file": ")" + path + R"(", "speed": "fast" }, )" + devices_config + "}") == OSVR_RETURN_SUCCESS);
+	stand_in::start_devices();
+	CHECK(wait_until([=] { return count_poses(0) >= controller_frames && count_poses(1) >= hmd_frames; }));
+	run_for(0.1);
+	stand_in::stop_devices();
+	CHECK(count_poses(0) == controller_frames);
+	CHECK(count_poses(1) == hmd_frames);
+	reset_plugin();
+	std::remove(path.c_str());
+}
+
+TEST(bad_configs_fail_to_load) {
+	const char* configs[] = {
+		R"({ "controllers": [ { "name": "x", "type": "Wiimote", "id": 0 } ] })",
+		R"({ "mode": "sometimes", "controllers": [] })",
+		R"({ "rate_hz": 0, "controllers": [] })",
+		R"({ "groups": { "MoveDevice": {} }, "controllers": [] })",
+		R"({ "controllers": [ { "name": "x", "type": "Move", "id": 0, "group": "Nowhere" } ] })",
+		R"({ "controllers": [ { "name": "x", "type": "Move", "id": 0, "stream": [ "everything" ] } ] })",
+		R"({ "replay": { "file": "/nonexistent/recording" }, "controllers": [] })",
+		R"({ "controllers": [ { "name": "x", "type": "Move", "id": 0 )"
+	};
+	for (const char* config : configs) {
+		reset_plugin();
+		stand_in::connect_controller(0, PSMController_Move);
+		CHECK(load_plugin(config) == OSVR_RETURN_FAILURE);
+		CHECK(stand_in::device_names().empty());
+	}
+	// A connected device of another type than configured is refused
+	reset_plugin();
+	stand_in::connect_controller(0, PSMController_Navi);
+	CHECK(load_plugin(R"({ "controllers": [ { "name": "x", "type": "Move", "id": 0 } ] })") == OSVR_RETURN_FAILURE);
+	CHECK(stand_in::logged("is not a Move controller"));
+	reset_plugin();
+}
+
+int main(int argc, char** argv) {
+	const std::string filter = argc > 1 ? argv[1] : "";
+	int failed_tests = 0, run = 0;
+	for (const TestCase& test : test_cases()) {
+		if (!filter.empty() && std::string(test.name).find(filter) == std::string::npos)
+			continue;
+		const int before = failed_checks;
+		std::printf("[ RUN  ] %s\n", test.name);
+		std::fflush(stdout);
+		test.run();
+		const bool passed = failed_checks == before;
+		std::printf("[ %s ] %s\n", passed ? " OK " : "FAIL", test.name);
+		failed_tests += !passed;
+		run++;
+	}
+	std::printf("%d of %d tests passed\n", run - failed_tests, run);
+	return failed_tests == 0 && run > 0 ? 0 : 1;
+}
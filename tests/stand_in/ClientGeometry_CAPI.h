@@ -0,0 +1,15 @@
+// Stand-in for PSMoveService's ClientGeometry_CAPI.h, see stand_in.h
+#pragma once
+
+typedef struct {
+	float x, y, z;
+} PSMVector3f;
+
+typedef struct {
+	float w, x, y, z;
+} PSMQuatf;
+
+typedef struct {
+	PSMVector3f Position;
+	PSMQuatf Orientation;
+} PSMPosef;
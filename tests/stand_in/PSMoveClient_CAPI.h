@@ -0,0 +1,268 @@
+// Stand-in for PSMoveService's PSMoveClient_CAPI.h, see stand_in.h. Only what the plugin uses is
+// declared, with the same names and the same shape as the PSMoveService 0.9 client API.
+#pragma once
+
+#include <stddef.h>
+#include "ClientGeometry_CAPI.h"
+
+#define PSMOVESERVICE_DEFAULT_ADDRESS "localhost"
+#define PSMOVESERVICE_DEFAULT_PORT "9512"
+#define PSM_DEFAULT_TIMEOUT 1000
+#define PSMOVESERVICE_MAX_CONTROLLER_COUNT 5
+#define PSMOVESERVICE_MAX_HMD_COUNT 4
+
+typedef enum {
+	PSMResult_Error = -1,
+	PSMResult_Success = 0,
+	PSMResult_Timeout = 1,
+	PSMResult_RequestSent = 2,
+	PSMResult_Canceled = 3,
+	PSMResult_NoData = 4
+} PSMResult;
+
+typedef enum {
+	PSMButtonState_UP = 0,
+	PSMButtonState_PRESSED = 1,
+	PSMButtonState_DOWN = 2,
+	PSMButtonState_RELEASED = 3
+} PSMButtonState;
+
+typedef enum {
+	PSMController_None = -1,
+	PSMController_Move,
+	PSMController_Navi,
+	PSMController_DualShock4,
+	PSMController_Virtual
+} PSMControllerType;
+
+typedef enum {
+	PSMHmd_None = -1,
+	PSMHmd_Morpheus = 0,
+	PSMHmd_Virtual = 1
+} PSMHmdType;
+
+typedef enum {
+	PSMStreamFlags_defaultStreamOptions = 0x00,
+	PSMStreamFlags_includePositionData = 0x01,
+	PSMStreamFlags_includePhysicsData = 0x02,
+	PSMStreamFlags_includeRawSensorData = 0x04,
+	PSMStreamFlags_includeCalibratedSensorData = 0x08,
+	PSMStreamFlags_includeRawTrackerData = 0x10,
+	PSMStreamFlags_disableROI = 0x20
+} PSMStreamFlags;
+
+typedef int PSMControllerID;
+typedef int PSMHmdID;
+typedef int PSMRequestID;
+
+typedef struct {
+	PSMVector3f LinearVelocityCmPerSec;
+	PSMVector3f LinearAccelerationCmPerSecSqr;
+	PSMVector3f AngularVelocityRadPerSec;
+	PSMVector3f AngularAccelerationRadPerSecSqr;
+	double TimeInSeconds;
+} PSMPhysicsData;
+
+typedef struct {
+	PSMVector3f Accelerometer;
+	PSMVector3f Gyroscope;
+	PSMVector3f Magnetometer;
+	double TimeInSeconds;
+} PSMPSMoveCalibratedSensorData;
+
+typedef struct {
+	PSMVector3f Accelerometer;
+	PSMVector3f Gyroscope;
+	double TimeInSeconds;
+} PSMDS4CalibratedSensorData;
+
+typedef struct {
+	PSMVector3f Accelerometer;
+	PSMVector3f Gyroscope;
+	double TimeInSeconds;
+} PSMMorpheusCalibratedSensorData;
+
+typedef struct {
+	bool bIsTrackingEnabled;
+	bool bIsCurrentlyTracking;
+	bool bIsOrientationValid;
+	bool bIsPositionValid;
+	PSMPosef Pose;
+	PSMPhysicsData PhysicsData;
+	PSMPSMoveCalibratedSensorData CalibratedSensorData;
+	PSMButtonState TriangleButton;
+	PSMButtonState CircleButton;
+	PSMButtonState CrossButton;
+	PSMButtonState SquareButton;
+	PSMButtonState SelectButton;
+	PSMButtonState StartButton;
+	PSMButtonState PSButton;
+	PSMButtonState MoveButton;
+	PSMButtonState TriggerButton;
+	unsigned char TriggerValue;
+} PSMPSMove;
+
+typedef struct {
+	PSMButtonState L1Button;
+	PSMButtonState L2Button;
+	PSMButtonState L3Button;
+	PSMButtonState CircleButton;
+	PSMButtonState CrossButton;
+	PSMButtonState PSButton;
+	PSMButtonState TriggerButton;
+	PSMButtonState DPadUpButton;
+	PSMButtonState DPadRightButton;
+	PSMButtonState DPadDownButton;
+	PSMButtonState DPadLeftButton;
+	unsigned char TriggerValue;
+	unsigned char Stick_XAxis;
+	unsigned char Stick_YAxis;
+} PSMPSNavi;
+
+typedef struct {
+	bool bIsTrackingEnabled;
+	bool bIsCurrentlyTracking;
+	bool bIsOrientationValid;
+	bool bIsPositionValid;
+	PSMPosef Pose;
+	PSMPhysicsData PhysicsData;
+	PSMDS4CalibratedSensorData CalibratedSensorData;
+	PSMButtonState DPadUpButton;
+	PSMButtonState DPadDownButton;
+	PSMButtonState DPadLeftButton;
+	PSMButtonState DPadRightButton;
+	PSMButtonState SquareButton;
+	PSMButtonState CrossButton;
+	PSMButtonState CircleButton;
+	PSMButtonState TriangleButton;
+	PSMButtonState L1Button;
+	PSMButtonState R1Button;
+	PSMButtonState L2Button;
+	PSMButtonState R2Button;
+	PSMButtonState L3Button;
+	PSMButtonState R3Button;
+	PSMButtonState ShareButton;
+	PSMButtonState OptionsButton;
+	PSMButtonState PSButton;
+	PSMButtonState TrackPadButton;
+	float LeftAnalogX;
+	float LeftAnalogY;
+	float RightAnalogX;
+	float RightAnalogY;
+	float LeftTriggerValue;
+	float RightTriggerValue;
+} PSMDualShock4;
+
+typedef struct {
+	bool bIsTrackingEnabled;
+	bool bIsCurrentlyTracking;
+	bool bIsPositionValid;
+	PSMPosef Pose;
+	PSMPhysicsData PhysicsData;
+} PSMVirtualController;
+
+typedef struct {
+	PSMControllerID ControllerID;
+	PSMControllerType ControllerType;
+	union {
+		PSMPSMove PSMoveState;
+		PSMPSNavi PSNaviState;
+		PSMDualShock4 PSDS4State;
+		PSMVirtualController VirtualController;
+	} ControllerState;
+	bool bValid;
+	int OutputSequenceNum;
+	int InputSequenceNum;
+	bool IsConnected;
+	long long DataFrameLastReceivedTime;
+	float DataFrameAverageFPS;
+	int ListenerCount;
+} PSMController;
+
+typedef struct {
+	bool bIsTrackingEnabled;
+	bool bIsCurrentlyTracking;
+	bool bIsOrientationValid;
+	bool bIsPositionValid;
+	PSMPosef Pose;
+	PSMPhysicsData PhysicsData;
+	PSMMorpheusCalibratedSensorData CalibratedSensorData;
+} PSMMorpheus;
+
+typedef struct {
+	bool bIsTrackingEnabled;
+	bool bIsCurrentlyTracking;
+	bool bIsPositionValid;
+	PSMPosef Pose;
+	PSMPhysicsData PhysicsData;
+} PSMVirtualHMD;
+
+typedef struct {
+	PSMHmdID HmdID;
+	PSMHmdType HmdType;
+	union {
+		PSMMorpheus MorpheusState;
+		PSMVirtualHMD VirtualHMDState;
+	} HmdState;
+	bool bValid;
+	int OutputSequenceNum;
+	bool IsConnected;
+	long long DataFrameLastReceivedTime;
+	float DataFrameAverageFPS;
+	int ListenerCount;
+} PSMHeadMountedDisplay;
+
+typedef struct {
+	PSMControllerID controller_id[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+	PSMControllerType controller_type[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+	int count;
+} PSMControllerList;
+
+typedef struct {
+	PSMHmdID hmd_id[PSMOVESERVICE_MAX_HMD_COUNT];
+	PSMHmdType hmd_type[PSMOVESERVICE_MAX_HMD_COUNT];
+	int count;
+} PSMHmdList;
+
+typedef struct {
+	PSMRequestID request_id;
+	PSMResult result_code;
+	void* opaque_request_handle;
+	void* opaque_response_handle;
+	union {
+		PSMControllerList controller_list;
+		PSMHmdList hmd_list;
+	} payload;
+	int payload_type;
+} PSMResponseMessage;
+
+typedef void (*PSMResponseCallback)(const PSMResponseMessage* response, void* userdata);
+
+extern "C" {
+	PSMResult PSM_Initialize(const char* host, const char* port, int timeout_ms);
+	PSMResult PSM_Shutdown();
+	PSMResult PSM_UpdateNoPollMessages();
+	bool PSM_GetIsConnected();
+	bool PSM_HasControllerListChanged();
+	bool PSM_HasHMDListChanged();
+
+	PSMResult PSM_GetControllerList(PSMControllerList* out_controller_list, int timeout_ms);
+	PSMResult PSM_GetControllerListAsync(PSMRequestID* out_request_id);
+	PSMResult PSM_GetHmdList(PSMHmdList* out_hmd_list, int timeout_ms);
+	PSMResult PSM_GetHmdListAsync(PSMRequestID* out_request_id);
+
+	PSMController* PSM_GetController(PSMControllerID controller_id);
+	PSMResult PSM_AllocateControllerListener(PSMControllerID controller_id);
+	PSMResult PSM_FreeControllerListener(PSMControllerID controller_id);
+	PSMResult PSM_StartControllerDataStreamAsync(PSMControllerID controller_id, unsigned int data_stream_flags, PSMRequestID* out_request_id);
+	PSMResult PSM_StopControllerDataStreamAsync(PSMControllerID controller_id, PSMRequestID* out_request_id);
+
+	PSMHeadMountedDisplay* PSM_GetHmd(PSMHmdID hmd_id);
+	PSMResult PSM_AllocateHmdListener(PSMHmdID hmd_id);
+	PSMResult PSM_FreeHmdListener(PSMHmdID hmd_id);
+	PSMResult PSM_StartHmdDataStreamAsync(PSMHmdID hmd_id, unsigned int data_stream_flags, PSMRequestID* out_request_id);
+	PSMResult PSM_StopHmdDataStreamAsync(PSMHmdID hmd_id, PSMRequestID* out_request_id);
+
+	PSMResult PSM_RegisterCallback(PSMRequestID request_id, PSMResponseCallback callback, void* callback_userdata);
+	PSMResult PSM_CancelCallback(PSMRequestID request_id);
+}
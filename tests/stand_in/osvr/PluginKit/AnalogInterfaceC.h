@@ -0,0 +1,14 @@
+// Stand-in for OSVR's osvr/PluginKit/AnalogInterfaceC.h, see stand_in.h
+#pragma once
+
+#include <osvr/PluginKit/DeviceInterfaceC.h>
+
+typedef struct OSVR_AnalogDeviceInterfaceObject* OSVR_AnalogDeviceInterface;
+
+extern "C" {
+	OSVR_ReturnCode osvrDeviceAnalogConfigure(OSVR_DeviceInitOptions opts, OSVR_AnalogDeviceInterface* iface, OSVR_ChannelCount num_chan);
+	OSVR_ReturnCode osvrDeviceAnalogSetValueTimestamped(OSVR_DeviceToken dev, OSVR_AnalogDeviceInterface iface,
+		OSVR_AnalogState val, OSVR_ChannelCount chan, const OSVR_TimeValue* timestamp);
+	OSVR_ReturnCode osvrDeviceAnalogSetValuesTimestamped(OSVR_DeviceToken dev, OSVR_AnalogDeviceInterface iface,
+		OSVR_AnalogState val[], OSVR_ChannelCount chans, const OSVR_TimeValue* timestamp);
+}
@@ -0,0 +1,12 @@
+// Stand-in for OSVR's osvr/PluginKit/ButtonInterfaceC.h, see stand_in.h
+#pragma once
+
+#include <osvr/PluginKit/DeviceInterfaceC.h>
+
+typedef struct OSVR_ButtonDeviceInterfaceObject* OSVR_ButtonDeviceInterface;
+
+extern "C" {
+	OSVR_ReturnCode osvrDeviceButtonConfigure(OSVR_DeviceInitOptions opts, OSVR_ButtonDeviceInterface* iface, OSVR_ChannelCount num_chan);
+	OSVR_ReturnCode osvrDeviceButtonSetValuesTimestamped(OSVR_DeviceToken dev, OSVR_ButtonDeviceInterface iface,
+		OSVR_ButtonState val[], OSVR_ChannelCount chans, const OSVR_TimeValue* timestamp);
+}
@@ -0,0 +1,12 @@
+// Stand-in for OSVR's osvr/PluginKit/DeviceInterfaceC.h, see stand_in.h
+#pragma once
+
+#include <osvr/Util/ClientReportTypesC.h>
+
+typedef struct OSVR_PluginRegContextObject* OSVR_PluginRegContext;
+typedef struct OSVR_DeviceTokenObject* OSVR_DeviceToken;
+typedef struct OSVR_DeviceInitObject* OSVR_DeviceInitOptions;
+
+extern "C" {
+	OSVR_DeviceInitOptions osvrDeviceCreateInitOptions(OSVR_PluginRegContext ctx);
+}
@@ -0,0 +1,65 @@
+// Stand-in for OSVR's C++ PluginKit wrapper, see stand_in.h. The templates forward to plain
+// registration functions, so the stand-in can hold on to update callbacks and owned objects.
+#pragma once
+
+#include <osvr/PluginKit/DeviceInterfaceC.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace osvr {
+	namespace pluginkit {
+		namespace detail {
+			void register_update_callback(OSVR_DeviceToken device, std::function<OSVR_ReturnCode()> update);
+			void register_for_deletion(OSVR_PluginRegContext ctx, std::function<void()> deleter);
+			void register_driver(OSVR_PluginRegContext ctx, const char* name, std::function<OSVR_ReturnCode(OSVR_PluginRegContext, const char*)> constructor);
+		}
+
+		class DeviceToken {
+		public:
+			DeviceToken() = default;
+			DeviceToken(const DeviceToken&) = delete;
+			DeviceToken& operator=(const DeviceToken&) = delete;
+
+			void initAsync(OSVR_PluginRegContext ctx, const std::string& name, OSVR_DeviceInitOptions options);
+			void sendJsonDescriptor(const std::string& json);
+			template <typename T>
+			void registerUpdateCallback(T* object) {
+				detail::register_update_callback(device_, [object] { return object->update(); });
+			}
+			operator OSVR_DeviceToken() const {
+				return device_;
+			}
+		private:
+			OSVR_DeviceToken device_ = nullptr;
+		};
+
+		class PluginContext {
+		public:
+			explicit PluginContext(OSVR_PluginRegContext ctx):ctx_(ctx) {}
+			OSVR_PluginRegContext get() const {
+				return ctx_;
+			}
+		private:
+			OSVR_PluginRegContext ctx_;
+		};
+
+		void log(OSVR_PluginRegContext ctx, OSVR_LogLevel level, const char* message);
+
+		// Takes ownership, the object is deleted when the plugin is unloaded
+		template <typename T>
+		T* registerObjectForDeletion(OSVR_PluginRegContext ctx, T* object) {
+			detail::register_for_deletion(ctx, [object] { delete object; });
+			return object;
+		}
+
+		template <typename T>
+		void registerDriverInstantiationCallback(OSVR_PluginRegContext ctx, const char* name, T* functor) {
+			std::shared_ptr<T> owned(functor);
+			detail::register_driver(ctx, name, [owned](OSVR_PluginRegContext context, const char* params) { return (*owned)(context, params); });
+		}
+	}
+}
+
+#define OSVR_PLUGIN(NAME) extern "C" OSVR_ReturnCode osvrPluginEntryPoint_##NAME(OSVR_PluginRegContext ctx)
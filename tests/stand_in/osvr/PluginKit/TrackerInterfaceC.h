@@ -0,0 +1,16 @@
+// Stand-in for OSVR's osvr/PluginKit/TrackerInterfaceC.h, see stand_in.h
+#pragma once
+
+#include <osvr/PluginKit/DeviceInterfaceC.h>
+
+typedef struct OSVR_TrackerDeviceInterfaceObject* OSVR_TrackerDeviceInterface;
+
+extern "C" {
+	OSVR_ReturnCode osvrDeviceTrackerConfigure(OSVR_DeviceInitOptions opts, OSVR_TrackerDeviceInterface* iface);
+	OSVR_ReturnCode osvrDeviceTrackerSendPoseTimestamped(OSVR_DeviceToken dev, OSVR_TrackerDeviceInterface iface,
+		const OSVR_PoseState* val, OSVR_ChannelCount sensor, const OSVR_TimeValue* timestamp);
+	OSVR_ReturnCode osvrDeviceTrackerSendVelocityTimestamped(OSVR_DeviceToken dev, OSVR_TrackerDeviceInterface iface,
+		const OSVR_VelocityState* val, OSVR_ChannelCount sensor, const OSVR_TimeValue* timestamp);
+	OSVR_ReturnCode osvrDeviceTrackerSendAccelerationTimestamped(OSVR_DeviceToken dev, OSVR_TrackerDeviceInterface iface,
+		const OSVR_AccelerationState* val, OSVR_ChannelCount sensor, const OSVR_TimeValue* timestamp);
+}
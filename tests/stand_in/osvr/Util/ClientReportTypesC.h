@@ -0,0 +1,83 @@
+// Stand-in for OSVR's report types and their inline accessors, see stand_in.h
+#pragma once
+
+#include <stdint.h>
+#include <osvr/Util/TimeValueC.h>
+
+typedef uint32_t OSVR_ChannelCount;
+typedef uint8_t OSVR_ButtonState;
+typedef double OSVR_AnalogState;
+typedef char OSVR_CBool;
+typedef int8_t OSVR_ReturnCode;
+
+#define OSVR_RETURN_SUCCESS (0)
+#define OSVR_RETURN_FAILURE (1)
+#define OSVR_BUTTON_PRESSED (1)
+#define OSVR_BUTTON_NOT_PRESSED (0)
+
+typedef enum {
+	OSVR_LOGLEVEL_TRACE,
+	OSVR_LOGLEVEL_DEBUG,
+	OSVR_LOGLEVEL_INFO,
+	OSVR_LOGLEVEL_NOTICE,
+	OSVR_LOGLEVEL_WARN,
+	OSVR_LOGLEVEL_ERROR,
+	OSVR_LOGLEVEL_CRITICAL
+} OSVR_LogLevel;
+
+typedef struct {
+	double data[3];
+} OSVR_Vec3;
+
+typedef struct {
+	double data[4];	// w, x, y, z
+} OSVR_Quaternion;
+
+typedef struct {
+	OSVR_Vec3 translation;
+	OSVR_Quaternion rotation;
+} OSVR_PoseState;
+
+typedef struct {
+	OSVR_Quaternion incrementalRotation;
+	double dt;
+} OSVR_IncrementalQuaternion;
+
+typedef OSVR_Vec3 OSVR_LinearVelocityState;
+typedef OSVR_Vec3 OSVR_LinearAccelerationState;
+typedef OSVR_IncrementalQuaternion OSVR_AngularVelocityState;
+typedef OSVR_IncrementalQuaternion OSVR_AngularAccelerationState;
+
+typedef struct {
+	OSVR_LinearVelocityState linearVelocity;
+	OSVR_CBool linearVelocityValid;
+	OSVR_AngularVelocityState angularVelocity;
+	OSVR_CBool angularVelocityValid;
+} OSVR_VelocityState;
+
+typedef struct {
+	OSVR_LinearAccelerationState linearAcceleration;
+	OSVR_CBool linearAccelerationValid;
+	OSVR_AngularAccelerationState angularAcceleration;
+	OSVR_CBool angularAccelerationValid;
+} OSVR_AccelerationState;
+
+inline void osvrVec3SetX(OSVR_Vec3* v, double value) { v->data[0] = value; }
+inline void osvrVec3SetY(OSVR_Vec3* v, double value) { v->data[1] = value; }
+inline void osvrVec3SetZ(OSVR_Vec3* v, double value) { v->data[2] = value; }
+inline double osvrVec3GetX(const OSVR_Vec3* v) { return v->data[0]; }
+inline double osvrVec3GetY(const OSVR_Vec3* v) { return v->data[1]; }
+inline double osvrVec3GetZ(const OSVR_Vec3* v) { return v->data[2]; }
+
+inline void osvrQuatSetIdentity(OSVR_Quaternion* q) {
+	q->data[0] = 1;
+	q->data[1] = q->data[2] = q->data[3] = 0;
+}
+inline void osvrQuatSetW(OSVR_Quaternion* q, double value) { q->data[0] = value; }
+inline void osvrQuatSetX(OSVR_Quaternion* q, double value) { q->data[1] = value; }
+inline void osvrQuatSetY(OSVR_Quaternion* q, double value) { q->data[2] = value; }
+inline void osvrQuatSetZ(OSVR_Quaternion* q, double value) { q->data[3] = value; }
+inline double osvrQuatGetW(const OSVR_Quaternion* q) { return q->data[0]; }
+inline double osvrQuatGetX(const OSVR_Quaternion* q) { return q->data[1]; }
+inline double osvrQuatGetY(const OSVR_Quaternion* q) { return q->data[2]; }
+inline double osvrQuatGetZ(const OSVR_Quaternion* q) { return q->data[3]; }
@@ -0,0 +1,17 @@
+// Stand-in for OSVR's osvr/Util/TimeValueC.h, see stand_in.h
+#pragma once
+
+#include <stdint.h>
+
+typedef int64_t OSVR_TimeValue_Seconds;
+typedef int32_t OSVR_TimeValue_Microseconds;
+
+typedef struct {
+	OSVR_TimeValue_Seconds seconds;
+	OSVR_TimeValue_Microseconds microseconds;
+} OSVR_TimeValue;
+
+extern "C" {
+	void osvrTimeValueGetNow(OSVR_TimeValue* tv);
+	void osvrTimeValueNormalize(OSVR_TimeValue* tv);
+}
@@ -0,0 +1,796 @@
+#include "stand_in.h"
+
+#include <osvr/PluginKit/TrackerInterfaceC.h>
+#include <osvr/PluginKit/AnalogInterfaceC.h>
+#include <osvr/PluginKit/ButtonInterfaceC.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace
+{
+	typedef std::chrono::steady_clock clock;
+
+	// One device on the synthetic service, keyed by (hmd, id)
+	struct ServiceDevice {
+		bool connected = false;
+		bool streaming = false;
+		unsigned int stream_flags = 0;
+		clock::time_point next_frame;
+		int input_step = 0;	// Drives buttons and analogs, only advances while moving
+		bool edited = false;	// Stopped, edited devices keep their edited pose and physics too
+		PSMController controller = {};
+		PSMHeadMountedDisplay hmd = {};
+	};
+	typedef std::pair<bool, int> DeviceKey;
+
+	struct Request {
+		enum Kind { Plain, ControllerList, HmdList, Refused, Ignored };
+		PSMRequestID id;
+		Kind kind;
+		PSMResponseCallback callback;
+		void* userdata;
+	};
+
+	struct Service {
+		std::mutex mutex;
+		// A map, so the state PSM_GetController() and PSM_GetHmd() hand out never moves
+		std::map<DeviceKey, ServiceDevice> devices;
+		std::vector<std::pair<int, std::function<void(PSMController&)>>> edits;
+		std::vector<Request> requests;
+		PSMRequestID next_request = 1;
+		bool up = true;
+		bool connected = false;
+		bool controllers_changed = false;
+		bool hmds_changed = false;
+		double frame_rate = 120;
+		stand_in::StreamStart stream_start = stand_in::StreamStart::Succeed;
+		bool moving = true;
+		double frozen_time = 0;
+		clock::time_point start = clock::now();
+		std::atomic<uint64_t> frames{ 0 };
+		std::atomic<uint64_t> updates{ 0 };
+	};
+	Service service;
+
+	struct Interface {
+		OSVR_ChannelCount count;	// 0 for a tracker, which takes any sensor
+	};
+
+	struct Device {
+		std::string name;
+		std::string descriptor;
+		std::function<OSVR_ReturnCode()> update;
+		std::vector<std::unique_ptr<Interface>> interfaces;
+	};
+
+	struct Server {
+		std::mutex mutex;
+		std::vector<std::unique_ptr<Device>> devices;
+		std::vector<std::function<void()>> deleters;
+		std::vector<std::pair<std::string, std::function<OSVR_ReturnCode(OSVR_PluginRegContext, const char*)>>> drivers;
+		std::vector<stand_in::Report> reports;
+		bool keep = true;
+		uint64_t count = 0;
+		uint64_t errors = 0;
+		std::vector<std::string> log;
+		std::vector<std::thread> threads;
+		std::atomic<bool> running{ false };
+	};
+	Server server;
+
+	double seconds_since(clock::time_point start) {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	PSMButtonState button(bool down) {
+		return down ? PSMButtonState_DOWN : PSMButtonState_UP;
+	}
+
+	template <typename State>
+	void fill_tracking(State& state, double t, double motion_t, bool moving, bool hold) {
+		if (hold) {
+			state.PhysicsData.TimeInSeconds = t;
+			return;
+		}
+		state.bIsTrackingEnabled = true;
+		state.bIsCurrentlyTracking = true;
+		state.bIsPositionValid = true;
+		state.Pose = stand_in::synthetic_pose(motion_t);
+		PSMPhysicsData& physics = state.PhysicsData;
+		const float speed = moving ? 1.0f : 0.0f;
+		physics.LinearVelocityCmPerSec = { -20 * std::sin((float)motion_t) * speed, 20 * std::cos(2 * (float)motion_t) * speed, 20 * std::cos((float)motion_t) * speed };
+		physics.LinearAccelerationCmPerSecSqr = { -20 * std::cos((float)motion_t) * speed, -40 * std::sin(2 * (float)motion_t) * speed, -20 * std::sin((float)motion_t) * speed };
+		physics.AngularVelocityRadPerSec = { 0, speed, 0 };
+		physics.AngularAccelerationRadPerSecSqr = { 0, 0, 0 };
+		physics.TimeInSeconds = t;
+	}
+
+	// The accelerometer's x axis counts frames, so a test can tell samples apart and check their order
+	template <typename Sensor>
+	void fill_sensor(Sensor& sensor, double t, int sequence) {
+		sensor.Accelerometer = { (float)sequence, 0, 1 };
+		sensor.Gyroscope = { 0, 1, 0 };
+		sensor.TimeInSeconds = t;
+	}
+
+	// Called with the service locked, advances one device by a frame
+	void deliver_frame(const DeviceKey& key, ServiceDevice& device, double t) {
+		const double motion_t = service.moving ? t : service.frozen_time;
+		const bool hold = !service.moving && device.edited;
+		if (service.moving)
+			device.input_step++;
+		const bool pressed = (device.input_step / 50) % 2 == 1;
+		const int trigger = (device.input_step / 25) % 256;
+		if (key.first) {
+			PSMHeadMountedDisplay& hmd = device.hmd;
+			hmd.OutputSequenceNum++;
+			if (hmd.HmdType == PSMHmd_Morpheus) {
+				fill_tracking(hmd.HmdState.MorpheusState, t, motion_t, service.moving, hold);
+				fill_sensor(hmd.HmdState.MorpheusState.CalibratedSensorData, t, hmd.OutputSequenceNum);
+			}
+			else {
+				fill_tracking(hmd.HmdState.VirtualHMDState, t, motion_t, service.moving, hold);
+			}
+		}
+		else {
+			PSMController& controller = device.controller;
+			controller.OutputSequenceNum++;
+			switch (controller.ControllerType) {
+			case PSMController_Move: {
+				PSMPSMove& move = controller.ControllerState.PSMoveState;
+				fill_tracking(move, t, motion_t, service.moving, hold);
+				fill_sensor(move.CalibratedSensorData, t, controller.OutputSequenceNum);
+				if (service.moving) {
+					move.CrossButton = button(pressed);
+					move.TriggerValue = (unsigned char)trigger;
+				}
+				break;
+			}
+			case PSMController_Navi: {
+				PSMPSNavi& navi = controller.ControllerState.PSNaviState;
+				if (service.moving) {
+					navi.CrossButton = button(pressed);
+					navi.TriggerValue = (unsigned char)trigger;
+					navi.Stick_XAxis = 128;
+					navi.Stick_YAxis = 128;
+				}
+				break;
+			}
+			case PSMController_DualShock4: {
+				PSMDualShock4& ds4 = controller.ControllerState.PSDS4State;
+				fill_tracking(ds4, t, motion_t, service.moving, hold);
+				fill_sensor(ds4.CalibratedSensorData, t, controller.OutputSequenceNum);
+				if (service.moving) {
+					ds4.CrossButton = button(pressed);
+					ds4.RightTriggerValue = trigger / 255.0f;
+				}
+				break;
+			}
+			case PSMController_Virtual:
+				fill_tracking(controller.ControllerState.VirtualController, t, motion_t, service.moving, hold);
+				break;
+			default:
+				break;
+			}
+		}
+		service.frames++;
+	}
+
+	ServiceDevice* find_streaming(const DeviceKey& key) {
+		auto found = service.devices.find(key);
+		return found != service.devices.end() && found->second.connected ? &found->second : nullptr;
+	}
+
+	PSMResult queue_request(Request::Kind kind, PSMRequestID* out_request_id) {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		if (!service.connected)
+			return PSMResult_Error;
+		*out_request_id = service.next_request++;
+		service.requests.push_back({ *out_request_id, kind, nullptr, nullptr });
+		return PSMResult_RequestSent;
+	}
+
+	PSMResult start_stream(const DeviceKey& key, unsigned int flags, PSMRequestID* out_request_id) {
+		Request::Kind kind = Request::Plain;
+		{
+			std::lock_guard<std::mutex> lock(service.mutex);
+			ServiceDevice* device = find_streaming(key);
+			if (!service.connected || !device)
+				return PSMResult_Error;
+			// A start that fails or goes unanswered leaves the device not streaming
+			if (service.stream_start == stand_in::StreamStart::Fail)
+				kind = Request::Refused;
+			else if (service.stream_start == stand_in::StreamStart::Ignore)
+				kind = Request::Ignored;
+			else {
+				device->streaming = true;
+				device->stream_flags = flags;
+				device->next_frame = clock::now();
+			}
+		}
+		return queue_request(kind, out_request_id);
+	}
+
+	PSMResult stop_stream(const DeviceKey& key, PSMRequestID* out_request_id) {
+		{
+			std::lock_guard<std::mutex> lock(service.mutex);
+			auto found = service.devices.find(key);
+			if (found != service.devices.end())
+				found->second.streaming = false;
+		}
+		return queue_request(Request::Plain, out_request_id);
+	}
+
+	// Called with the service locked
+	void fill_lists(PSMControllerList& controllers, PSMHmdList& hmds) {
+		controllers.count = 0;
+		hmds.count = 0;
+		for (auto& entry : service.devices) {
+			if (!entry.second.connected)
+				continue;
+			if (entry.first.first && hmds.count < PSMOVESERVICE_MAX_HMD_COUNT) {
+				hmds.hmd_id[hmds.count] = entry.first.second;
+				hmds.hmd_type[hmds.count++] = entry.second.hmd.HmdType;
+			}
+			else if (!entry.first.first && controllers.count < PSMOVESERVICE_MAX_CONTROLLER_COUNT) {
+				controllers.controller_id[controllers.count] = entry.first.second;
+				controllers.controller_type[controllers.count++] = entry.second.controller.ControllerType;
+			}
+		}
+	}
+
+	void connect_device(const DeviceKey& key, int type) {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		ServiceDevice& device = service.devices[key];
+		if (device.connected)
+			return;
+		// Nothing reads a disconnected device's state, so it can be set up right here
+		device = ServiceDevice();
+		device.connected = true;
+		if (key.first) {
+			device.hmd.HmdID = key.second;
+			device.hmd.HmdType = (PSMHmdType)type;
+			device.hmd.bValid = true;
+			device.hmd.IsConnected = true;
+			service.hmds_changed = true;
+		}
+		else {
+			device.controller.ControllerID = key.second;
+			device.controller.ControllerType = (PSMControllerType)type;
+			device.controller.bValid = true;
+			device.controller.IsConnected = true;
+			service.controllers_changed = true;
+		}
+		deliver_frame(key, device, seconds_since(service.start));
+	}
+
+	void disconnect_device(const DeviceKey& key) {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		auto found = service.devices.find(key);
+		if (found == service.devices.end() || !found->second.connected)
+			return;
+		found->second.connected = false;
+		found->second.streaming = false;
+		(key.first ? service.hmds_changed : service.controllers_changed) = true;
+	}
+
+	Device* device(OSVR_DeviceToken token) {
+		return reinterpret_cast<Device*>(token);
+	}
+
+	template <typename Value>
+	OSVR_ReturnCode record(stand_in::ReportKind kind, OSVR_DeviceToken token, const void* iface, OSVR_ChannelCount channel,
+		OSVR_ChannelCount channels_used, const OSVR_TimeValue* timestamp, const Value* values, size_t count) {
+		const Interface* target = static_cast<const Interface*>(iface);
+		std::lock_guard<std::mutex> lock(server.mutex);
+		server.count++;
+		if (!token || !target || (target->count != 0 && channels_used > target->count)) {
+			server.errors++;
+			return OSVR_RETURN_FAILURE;
+		}
+		if (!server.keep)
+			return OSVR_RETURN_SUCCESS;
+		stand_in::Report report;
+		report.kind = kind;
+		report.device = device(token)->name;
+		report.channel = channel;
+		report.time = timestamp->seconds + timestamp->microseconds / 1e6;
+		report.values.assign(values, values + count);
+		server.reports.push_back(std::move(report));
+		return OSVR_RETURN_SUCCESS;
+	}
+
+	template <typename Handle>
+	OSVR_ReturnCode configure(OSVR_DeviceInitOptions opts, Handle* iface, OSVR_ChannelCount count) {
+		std::lock_guard<std::mutex> lock(server.mutex);
+		Device* target = reinterpret_cast<Device*>(opts);
+		target->interfaces.emplace_back(new Interface{ count });
+		*iface = reinterpret_cast<Handle>(target->interfaces.back().get());
+		return OSVR_RETURN_SUCCESS;
+	}
+}
+
+namespace stand_in {
+
+	void reset() {
+		unload();
+		{
+			std::lock_guard<std::mutex> lock(service.mutex);
+			service.devices.clear();
+			service.edits.clear();
+			service.requests.clear();
+			service.up = true;
+			service.connected = false;
+			service.controllers_changed = service.hmds_changed = false;
+			service.frame_rate = 120;
+			service.stream_start = stand_in::StreamStart::Succeed;
+			service.moving = true;
+			service.start = clock::now();
+			service.frames = 0;
+			service.updates = 0;
+		}
+		std::lock_guard<std::mutex> lock(server.mutex);
+		server.devices.clear();
+		server.drivers.clear();
+		server.reports.clear();
+		server.keep = true;
+		server.count = 0;
+		server.errors = 0;
+		server.log.clear();
+	}
+
+	void connect_controller(int id, PSMControllerType type) {
+		connect_device(DeviceKey(false, id), type);
+	}
+	void disconnect_controller(int id) {
+		disconnect_device(DeviceKey(false, id));
+	}
+	void connect_hmd(int id, PSMHmdType type) {
+		connect_device(DeviceKey(true, id), type);
+	}
+	void disconnect_hmd(int id) {
+		disconnect_device(DeviceKey(true, id));
+	}
+
+	void edit_controller(int id, std::function<void(PSMController&)> edit) {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		service.edits.emplace_back(id, std::move(edit));
+	}
+
+	void set_service_up(bool up) {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		service.up = up;
+	}
+
+	void set_frame_rate(double hz) {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		service.frame_rate = hz;
+	}
+
+	void set_stream_start(StreamStart start) {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		service.stream_start = start;
+	}
+
+	void set_motion(bool moving) {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		if (service.moving && !moving)
+			service.frozen_time = seconds_since(service.start);
+		service.moving = moving;
+		if (moving) {
+			for (auto& entry : service.devices)
+				entry.second.edited = false;
+		}
+	}
+
+	// A circle in the horizontal plane with a bob on top, turning once every 2 pi seconds
+	PSMPosef synthetic_pose(double t) {
+		PSMPosef pose;
+		pose.Position = { 20 * (float)std::cos(t), 120 + 10 * (float)std::sin(2 * t), 20 * (float)std::sin(t) };
+		pose.Orientation = { (float)std::cos(t / 2), 0, (float)std::sin(t / 2), 0 };
+		return pose;
+	}
+
+	uint64_t frames_delivered() {
+		return service.frames;
+	}
+	uint64_t service_updates() {
+		return service.updates;
+	}
+
+	void keep_reports(bool keep) {
+		std::lock_guard<std::mutex> lock(server.mutex);
+		server.keep = keep;
+	}
+	std::vector<Report> reports() {
+		std::lock_guard<std::mutex> lock(server.mutex);
+		return server.reports;
+	}
+	void clear_reports() {
+		std::lock_guard<std::mutex> lock(server.mutex);
+		server.reports.clear();
+	}
+	uint64_t report_count() {
+		std::lock_guard<std::mutex> lock(server.mutex);
+		return server.count;
+	}
+	uint64_t channel_errors() {
+		std::lock_guard<std::mutex> lock(server.mutex);
+		return server.errors;
+	}
+
+	std::vector<std::string> device_names() {
+		std::lock_guard<std::mutex> lock(server.mutex);
+		std::vector<std::string> names;
+		for (const std::unique_ptr<Device>& entry : server.devices) {
+			if (!entry->name.empty())
+				names.push_back(entry->name);
+		}
+		return names;
+	}
+	std::string descriptor(const std::string& name) {
+		std::lock_guard<std::mutex> lock(server.mutex);
+		for (const std::unique_ptr<Device>& entry : server.devices) {
+			if (entry->name == name)
+				return entry->descriptor;
+		}
+		return std::string();
+	}
+
+	OSVR_PluginRegContext context() {
+		return reinterpret_cast<OSVR_PluginRegContext>(&server);
+	}
+
+	OSVR_ReturnCode instantiate(const std::string& driver, const std::string& params) {
+		std::function<OSVR_ReturnCode(OSVR_PluginRegContext, const char*)> constructor;
+		{
+			std::lock_guard<std::mutex> lock(server.mutex);
+			for (auto& entry : server.drivers) {
+				if (entry.first == driver)
+					constructor = entry.second;
+			}
+		}
+		return constructor ? constructor(context(), params.c_str()) : OSVR_RETURN_FAILURE;
+	}
+
+	OSVR_ReturnCode update(const std::string& name) {
+		std::function<OSVR_ReturnCode()> callback;
+		{
+			std::lock_guard<std::mutex> lock(server.mutex);
+			for (const std::unique_ptr<Device>& entry : server.devices) {
+				if (entry->name == name)
+					callback = entry->update;
+			}
+		}
+		return callback ? callback() : OSVR_RETURN_FAILURE;
+	}
+
+	void start_devices() {
+		std::lock_guard<std::mutex> lock(server.mutex);
+		server.running = true;
+		for (const std::unique_ptr<Device>& entry : server.devices) {
+			if (!entry->update)
+				continue;
+			std::function<OSVR_ReturnCode()> callback = entry->update;
+			server.threads.emplace_back([callback] {
+				while (server.running)
+					callback();
+			});
+		}
+	}
+
+	void stop_devices() {
+		std::vector<std::thread> threads;
+		{
+			std::lock_guard<std::mutex> lock(server.mutex);
+			server.running = false;
+			threads.swap(server.threads);
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+	}
+
+	void unload() {
+		stop_devices();
+		std::vector<std::function<void()>> deleters;
+		{
+			std::lock_guard<std::mutex> lock(server.mutex);
+			deleters.swap(server.deleters);
+		}
+		// Newest first, like OSVR tearing a plugin down
+		for (auto deleter = deleters.rbegin(); deleter != deleters.rend(); ++deleter)
+			(*deleter)();
+	}
+
+	std::vector<std::string> log_messages() {
+		std::lock_guard<std::mutex> lock(server.mutex);
+		return server.log;
+	}
+	bool logged(const std::string& text) {
+		std::lock_guard<std::mutex> lock(server.mutex);
+		for (const std::string& message : server.log) {
+			if (message.find(text) != std::string::npos)
+				return true;
+		}
+		return false;
+	}
+}
+
+namespace osvr {
+	namespace pluginkit {
+		namespace detail {
+			void register_update_callback(OSVR_DeviceToken token, std::function<OSVR_ReturnCode()> update) {
+				std::lock_guard<std::mutex> lock(server.mutex);
+				device(token)->update = std::move(update);
+			}
+			void register_for_deletion(OSVR_PluginRegContext, std::function<void()> deleter) {
+				std::lock_guard<std::mutex> lock(server.mutex);
+				server.deleters.push_back(std::move(deleter));
+			}
+			void register_driver(OSVR_PluginRegContext, const char* name, std::function<OSVR_ReturnCode(OSVR_PluginRegContext, const char*)> constructor) {
+				std::lock_guard<std::mutex> lock(server.mutex);
+				server.drivers.emplace_back(name, std::move(constructor));
+			}
+		}
+
+		void DeviceToken::initAsync(OSVR_PluginRegContext, const std::string& name, OSVR_DeviceInitOptions options) {
+			std::lock_guard<std::mutex> lock(server.mutex);
+			reinterpret_cast<Device*>(options)->name = name;
+			device_ = reinterpret_cast<OSVR_DeviceToken>(options);
+		}
+		void DeviceToken::sendJsonDescriptor(const std::string& json) {
+			std::lock_guard<std::mutex> lock(server.mutex);
+			device(device_)->descriptor = json;
+		}
+
+		void log(OSVR_PluginRegContext, OSVR_LogLevel level, const char* message) {
+			static const bool verbose = std::getenv("STAND_IN_VERBOSE") != nullptr;
+			if (verbose)
+				std::fprintf(stderr, "[%d] %s\n", (int)level, message);
+			std::lock_guard<std::mutex> lock(server.mutex);
+			server.log.push_back(message);
+		}
+	}
+}
+
+extern "C" {
+	void osvrTimeValueGetNow(OSVR_TimeValue* tv) {
+		const long long us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		tv->seconds = us / 1000000;
+		tv->microseconds = (OSVR_TimeValue_Microseconds)(us % 1000000);
+	}
+
+	void osvrTimeValueNormalize(OSVR_TimeValue* tv) {
+		tv->seconds += tv->microseconds / 1000000;
+		tv->microseconds %= 1000000;
+		if (tv->microseconds < 0) {
+			tv->seconds--;
+			tv->microseconds += 1000000;
+		}
+	}
+
+	OSVR_DeviceInitOptions osvrDeviceCreateInitOptions(OSVR_PluginRegContext) {
+		std::lock_guard<std::mutex> lock(server.mutex);
+		server.devices.emplace_back(new Device());
+		return reinterpret_cast<OSVR_DeviceInitOptions>(server.devices.back().get());
+	}
+
+	OSVR_ReturnCode osvrDeviceTrackerConfigure(OSVR_DeviceInitOptions opts, OSVR_TrackerDeviceInterface* iface) {
+		return configure(opts, iface, 0);
+	}
+	OSVR_ReturnCode osvrDeviceButtonConfigure(OSVR_DeviceInitOptions opts, OSVR_ButtonDeviceInterface* iface, OSVR_ChannelCount num_chan) {
+		return configure(opts, iface, num_chan);
+	}
+	OSVR_ReturnCode osvrDeviceAnalogConfigure(OSVR_DeviceInitOptions opts, OSVR_AnalogDeviceInterface* iface, OSVR_ChannelCount num_chan) {
+		return configure(opts, iface, num_chan);
+	}
+
+	OSVR_ReturnCode osvrDeviceTrackerSendPoseTimestamped(OSVR_DeviceToken dev, OSVR_TrackerDeviceInterface iface,
+		const OSVR_PoseState* val, OSVR_ChannelCount sensor, const OSVR_TimeValue* timestamp) {
+		const double values[] = { val->translation.data[0], val->translation.data[1], val->translation.data[2],
+			val->rotation.data[0], val->rotation.data[1], val->rotation.data[2], val->rotation.data[3] };
+		return record(stand_in::ReportKind::Pose, dev, iface, sensor, 0, timestamp, values, 7);
+	}
+	OSVR_ReturnCode osvrDeviceTrackerSendVelocityTimestamped(OSVR_DeviceToken dev, OSVR_TrackerDeviceInterface iface,
+		const OSVR_VelocityState* val, OSVR_ChannelCount sensor, const OSVR_TimeValue* timestamp) {
+		return record(stand_in::ReportKind::Velocity, dev, iface, sensor, 0, timestamp, val->linearVelocity.data, 3);
+	}
+	OSVR_ReturnCode osvrDeviceTrackerSendAccelerationTimestamped(OSVR_DeviceToken dev, OSVR_TrackerDeviceInterface iface,
+		const OSVR_AccelerationState* val, OSVR_ChannelCount sensor, const OSVR_TimeValue* timestamp) {
+		return record(stand_in::ReportKind::Acceleration, dev, iface, sensor, 0, timestamp, val->linearAcceleration.data, 3);
+	}
+
+	OSVR_ReturnCode osvrDeviceButtonSetValuesTimestamped(OSVR_DeviceToken dev, OSVR_ButtonDeviceInterface iface,
+		OSVR_ButtonState val[], OSVR_ChannelCount chans, const OSVR_TimeValue* timestamp) {
+		return record(stand_in::ReportKind::Buttons, dev, iface, chans, chans, timestamp, val, chans);
+	}
+
+	OSVR_ReturnCode osvrDeviceAnalogSetValueTimestamped(OSVR_DeviceToken dev, OSVR_AnalogDeviceInterface iface,
+		OSVR_AnalogState val, OSVR_ChannelCount chan, const OSVR_TimeValue* timestamp) {
+		return record(stand_in::ReportKind::Analog, dev, iface, chan, chan + 1, timestamp, &val, 1);
+	}
+	OSVR_ReturnCode osvrDeviceAnalogSetValuesTimestamped(OSVR_DeviceToken dev, OSVR_AnalogDeviceInterface iface,
+		OSVR_AnalogState val[], OSVR_ChannelCount chans, const OSVR_TimeValue* timestamp) {
+		return record(stand_in::ReportKind::Analogs, dev, iface, chans, chans, timestamp, val, chans);
+	}
+
+	PSMResult PSM_Initialize(const char*, const char*, int) {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		service.connected = service.up;
+		return service.connected ? PSMResult_Success : PSMResult_Error;
+	}
+
+	PSMResult PSM_Shutdown() {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		service.connected = false;
+		service.requests.clear();
+		for (auto& entry : service.devices)
+			entry.second.streaming = false;
+		return PSMResult_Success;
+	}
+
+	PSMResult PSM_UpdateNoPollMessages() {
+		std::vector<std::pair<Request, PSMResponseMessage>> answers;
+		{
+			std::lock_guard<std::mutex> lock(service.mutex);
+			service.updates++;
+			if (!service.up)
+				service.connected = false;
+			if (!service.connected)
+				return PSMResult_Error;
+
+			for (auto& edit : service.edits) {
+				ServiceDevice* device = find_streaming(DeviceKey(false, edit.first));
+				if (device) {
+					edit.second(device->controller);
+					device->edited = true;
+				}
+			}
+			service.edits.clear();
+
+			std::vector<Request> unanswered;
+			for (const Request& request : service.requests) {
+				if (request.kind == Request::Ignored)
+					unanswered.push_back(request);
+				if (!request.callback || request.kind == Request::Ignored)
+					continue;
+				PSMResponseMessage response = {};
+				response.request_id = request.id;
+				response.result_code = request.kind == Request::Refused ? PSMResult_Error : PSMResult_Success;
+				PSMHmdList hmds;
+				fill_lists(response.payload.controller_list, hmds);
+				if (request.kind == Request::HmdList)
+					response.payload.hmd_list = hmds;
+				answers.emplace_back(request, response);
+			}
+			service.requests.swap(unanswered);
+
+			const clock::time_point now = clock::now();
+			const double t = seconds_since(service.start);
+			const clock::duration period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(service.frame_rate > 0 ? 1.0 / service.frame_rate : 0.0));
+			for (auto& entry : service.devices) {
+				ServiceDevice& device = entry.second;
+				if (!device.connected || !device.streaming || now < device.next_frame)
+					continue;
+				device.next_frame += period;
+				if (device.next_frame < now)
+					device.next_frame = now + period;
+				deliver_frame(entry.first, device, t);
+			}
+		}
+		for (auto& answer : answers)
+			answer.first.callback(&answer.second, answer.first.userdata);
+		return PSMResult_Success;
+	}
+
+	bool PSM_GetIsConnected() {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		return service.connected && service.up;
+	}
+
+	bool PSM_HasControllerListChanged() {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		const bool changed = service.controllers_changed;
+		service.controllers_changed = false;
+		return changed;
+	}
+
+	bool PSM_HasHMDListChanged() {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		const bool changed = service.hmds_changed;
+		service.hmds_changed = false;
+		return changed;
+	}
+
+	PSMResult PSM_GetControllerList(PSMControllerList* out_controller_list, int) {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		if (!service.connected)
+			return PSMResult_Error;
+		PSMHmdList hmds;
+		fill_lists(*out_controller_list, hmds);
+		return PSMResult_Success;
+	}
+
+	PSMResult PSM_GetHmdList(PSMHmdList* out_hmd_list, int) {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		if (!service.connected)
+			return PSMResult_Error;
+		PSMControllerList controllers;
+		fill_lists(controllers, *out_hmd_list);
+		return PSMResult_Success;
+	}
+
+	PSMResult PSM_GetControllerListAsync(PSMRequestID* out_request_id) {
+		return queue_request(Request::ControllerList, out_request_id);
+	}
+
+	PSMResult PSM_GetHmdListAsync(PSMRequestID* out_request_id) {
+		return queue_request(Request::HmdList, out_request_id);
+	}
+
+	PSMController* PSM_GetController(PSMControllerID controller_id) {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		return &service.devices[DeviceKey(false, controller_id)].controller;
+	}
+
+	PSMHeadMountedDisplay* PSM_GetHmd(PSMHmdID hmd_id) {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		return &service.devices[DeviceKey(true, hmd_id)].hmd;
+	}
+
+	PSMResult PSM_AllocateControllerListener(PSMControllerID) {
+		return PSMResult_Success;
+	}
+	PSMResult PSM_FreeControllerListener(PSMControllerID) {
+		return PSMResult_Success;
+	}
+	PSMResult PSM_AllocateHmdListener(PSMHmdID) {
+		return PSMResult_Success;
+	}
+	PSMResult PSM_FreeHmdListener(PSMHmdID) {
+		return PSMResult_Success;
+	}
+
+	PSMResult PSM_StartControllerDataStreamAsync(PSMControllerID controller_id, unsigned int data_stream_flags, PSMRequestID* out_request_id) {
+		return start_stream(DeviceKey(false, controller_id), data_stream_flags, out_request_id);
+	}
+	PSMResult PSM_StopControllerDataStreamAsync(PSMControllerID controller_id, PSMRequestID* out_request_id) {
+		return stop_stream(DeviceKey(false, controller_id), out_request_id);
+	}
+	PSMResult PSM_StartHmdDataStreamAsync(PSMHmdID hmd_id, unsigned int data_stream_flags, PSMRequestID* out_request_id) {
+		return start_stream(DeviceKey(true, hmd_id), data_stream_flags, out_request_id);
+	}
+	PSMResult PSM_StopHmdDataStreamAsync(PSMHmdID hmd_id, PSMRequestID* out_request_id) {
+		return stop_stream(DeviceKey(true, hmd_id), out_request_id);
+	}
+
+	PSMResult PSM_RegisterCallback(PSMRequestID request_id, PSMResponseCallback callback, void* callback_userdata) {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		for (Request& request : service.requests) {
+			if (request.id == request_id) {
+				request.callback = callback;
+				request.userdata = callback_userdata;
+				return PSMResult_Success;
+			}
+		}
+		return PSMResult_Error;
+	}
+
+	PSMResult PSM_CancelCallback(PSMRequestID request_id) {
+		std::lock_guard<std::mutex> lock(service.mutex);
+		for (Request& request : service.requests) {
+			if (request.id == request_id)
+				request.callback = nullptr;
+		}
+		return PSMResult_Success;
+	}
+}
@@ -0,0 +1,80 @@
+// Headless stand-ins for the PSMoveService client library and the OSVR PluginKit, so the plugin can
+// be built and driven without either. The headers next to this one declare the subset of both APIs
+// the plugin uses; stand_in.cpp implements them against a synthetic service and a recording server.
+//
+// The service side simulates devices that move along a fixed path and deliver frames at a set rate
+// while they stream, answering requests on the next PSM_UpdateNoPollMessages() like the real client.
+// The OSVR side records every report, and runs each device's update callback on its own thread on
+// request, like an asynchronous OSVR device.
+#pragma once
+
+#include <PSMoveClient_CAPI.h>
+#include <osvr/PluginKit/PluginKit.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace stand_in {
+
+	// Drops every device, report, log message and registration, and brings the service back up
+	void reset();
+
+	// Service side. Devices appear in and disappear from the device lists at once; state edits
+	// are applied on the next PSM_UpdateNoPollMessages(), as the real client only changes state there.
+	void connect_controller(int id, PSMControllerType type);
+	void disconnect_controller(int id);
+	void connect_hmd(int id, PSMHmdType type);
+	void disconnect_hmd(int id);
+	void edit_controller(int id, std::function<void(PSMController&)> edit);
+	// While down, connecting fails and a connected client loses its connection
+	void set_service_up(bool up);
+	// How often each streaming device delivers a frame, 0 for a frame on every update
+	void set_frame_rate(double hz);
+	// How the service answers requests to start a stream from now on. A start that fails or is
+	// ignored, never answered, leaves the device connected but not streaming.
+	enum class StreamStart { Succeed, Fail, Ignore };
+	void set_stream_start(StreamStart start);
+	// Stopped devices still deliver frames, with the same pose, buttons and analogs every time, and
+	// no velocity. Edits made while stopped stick, tracking included, until the devices move again.
+	void set_motion(bool moving);
+	// The pose the service reports at t seconds into its run, in centimeters
+	PSMPosef synthetic_pose(double t);
+	uint64_t frames_delivered();
+	uint64_t service_updates();
+
+	// OSVR side
+	enum class ReportKind { Pose, Velocity, Acceleration, Buttons, Analog, Analogs };
+	struct Report {
+		ReportKind kind;
+		std::string device;
+		OSVR_ChannelCount channel;	// Sensor or channel, or the channel count of a batch
+		double time;	// Report timestamp, in seconds
+		std::vector<double> values;	// Position then orientation for a pose, the values for a batch
+	};
+	// Keeping every report costs time on the update threads, so benchmarks can turn it off
+	void keep_reports(bool keep);
+	std::vector<Report> reports();
+	void clear_reports();
+	uint64_t report_count();
+	// Reports that named a channel its interface doesn't have
+	uint64_t channel_errors();
+
+	std::vector<std::string> device_names();
+	std::string descriptor(const std::string& device);
+
+	// The context to call the plugin's entry point with, then instantiate a driver it registered
+	OSVR_PluginRegContext context();
+	OSVR_ReturnCode instantiate(const std::string& driver, const std::string& params);
+	// Calls a device's update callback once on this thread
+	OSVR_ReturnCode update(const std::string& device);
+	// Runs every device's update callback in a loop on its own thread, until stopped
+	void start_devices();
+	void stop_devices();
+	// Stops the devices and deletes every object the plugin handed over, like unloading it
+	void unload();
+
+	std::vector<std::string> log_messages();
+	bool logged(const std::string& text);
+}